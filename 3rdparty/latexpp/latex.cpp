@@ -8,6 +8,9 @@
 #include <wkhtmltox/image.h>
 #include <windows.h>
 
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
 Latex::V8 Latex::_v8;
 
 Latex::Latex(WarningBehavior behavior)
@@ -70,29 +73,6 @@ std::string & Latex::exe_folder_path()
     return _p;
 }
 
-std::string& Latex::tmp_html_path()
-{
-    static std::string _p;
-    if (_p.empty())
-    {
-        _p = Latex::exe_folder_path() + "tmp.html";
-    }
-
-    return _p;
-}
-
-std::string& Latex::tmp_png_path()
-{
-    static std::string _p;
-    if (_p.empty())
-    {
-        _p = Latex::exe_folder_path() + "tmp.png";
-    }
-
-    return _p;
-}
-
-
 void Latex::swap(Latex &other) noexcept
 {
 	// Enable ADL
@@ -157,7 +137,7 @@ std::string Latex::to_complete_html(const std::string &latex) const
 	
 	html += "<head>\n<meta charset='utf-8'/>\n";
 	html += "<link rel='stylesheet' type='text/css' ";
- 	html += "href='" + _stylesheet + "'>\n";
+ 	html += "href='" + _stylesheet_url() + "'>\n";
 	
 	if (! _additional_css.empty())
 	{
@@ -177,24 +157,54 @@ void Latex::to_image(const std::string &latex,
 				  const std::string &filepath,
 				  ImageFormat format) const
 {
-    std::ofstream temp(Latex::tmp_html_path());
+	auto converter = _new_converter(to_complete_html(latex), filepath, format);
 	
-	if (! temp) throw FileException("Could not open temporary file!");
+	if (! wkhtmltoimage_convert(converter))
+	{
+		wkhtmltoimage_destroy_converter(converter);
+		
+		throw ConversionException("Could not convert to png!");
+	}
 	
-	temp << to_complete_html(latex);
+	wkhtmltoimage_destroy_converter(converter);
+}
 
-	temp.close();
-	
-	auto converter = _new_converter(filepath, format);
+void Latex::to_bitmap(const std::string &latex,
+				   std::vector<unsigned char> &pixels,
+				   int &width,
+				   int &height) const
+{
+	auto converter = _new_converter(to_complete_html(latex), "", ImageFormat::BMP);
 	
 	if (! wkhtmltoimage_convert(converter))
 	{
-		throw ConversionException("Could not convert to png!");
+		wkhtmltoimage_destroy_converter(converter);
+		
+		throw ConversionException("Could not convert to bitmap!");
 	}
 	
+	// The output buffer is owned by the converter
+	const unsigned char* data = nullptr;
+	
+	long length = wkhtmltoimage_get_output(converter, &data);
+	
+	unsigned char* rgba = stbi_load_from_memory(data,
+												static_cast<int>(length),
+												&width,
+												&height,
+												nullptr,
+												4);
+	
 	wkhtmltoimage_destroy_converter(converter);
 	
-	//remove(Latex::tmp_html_path().c_str());
+	if (! rgba)
+	{
+		throw ConversionException("Could not decode bitmap!");
+	}
+	
+	pixels.assign(rgba, rgba + width * height * 4);
+	
+	stbi_image_free(rgba);
 }
 
 void Latex::to_png(const std::string &latex,
@@ -335,12 +345,34 @@ void _log(wkhtmltoimage_converter*, const char* message)
 	std::clog << message << std::endl;
 }
 
+std::string Latex::_stylesheet_url() const
+{
+	// Already absolute (drive letter, UNC path or some URL)
+	if (_stylesheet.find(':') != std::string::npos ||
+		_stylesheet.compare(0, 2, "\\\\") == 0)
+	{
+		return _stylesheet;
+	}
+	
+	std::string url = "file:///" + Latex::exe_folder_path() + _stylesheet;
+	
+	for (auto i = url.begin(); i != url.end(); ++i)
+	{
+		if (*i == '\\') *i = '/';
+	}
+	
+	return url;
+}
+
 wkhtmltoimage_converter*
-Latex::_new_converter(const std::string& filepath, ImageFormat format) const
+Latex::_new_converter(const std::string& html,
+					  const std::string& filepath,
+					  ImageFormat format) const
 {
 	auto settings = _new_converter_settings(filepath, format);
 	
-	auto converter = wkhtmltoimage_create_converter(settings, nullptr);
+	// Without an "in" setting, wkhtmltoimage converts the data passed here
+	auto converter = wkhtmltoimage_create_converter(settings, html.c_str());
 	
 	wkhtmltoimage_set_error_callback(converter, _throw);
 	
@@ -367,10 +399,7 @@ Latex::_new_converter_settings(const std::string& filepath,
 									 "transparent",
 									 "false");
 	
-	wkhtmltoimage_set_global_setting(settings,
-									 "in",
-                                        Latex::tmp_html_path().c_str());
-	
+	// An empty "out" keeps the image in the converter's output buffer
 	wkhtmltoimage_set_global_setting(settings,
 									 "out",
 									 filepath.c_str());
@@ -383,6 +412,8 @@ Latex::_new_converter_settings(const std::string& filepath,
 		case ImageFormat::JPG: fmt = "jpg"; break;
 			
 		case ImageFormat::SVG: fmt = "svg"; break;
+			
+		case ImageFormat::BMP: fmt = "bmp"; break;
 	}
 	
 	wkhtmltoimage_set_global_setting(settings,
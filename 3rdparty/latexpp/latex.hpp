@@ -12,6 +12,7 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <v8.h>
 
 class wkhtmltoimage_converter;
@@ -22,8 +23,6 @@ class Latex
 public:
 
     static std::string&     exe_folder_path();
-    static std::string&     tmp_html_path();
-    static std::string&     tmp_png_path();
 
 	/***********************************************************************//*!
 	*
@@ -31,7 +30,7 @@ public:
 	*
 	***************************************************************************/
 
-	enum class ImageFormat { PNG, SVG, JPG };
+	enum class ImageFormat { PNG, SVG, JPG, BMP };
 	
 	/***********************************************************************//*!
 	*
@@ -323,6 +322,36 @@ public:
 	virtual void to_svg(const std::string& latex,
 					 const std::string& filepath) const;
 	
+	/***********************************************************************//*!
+	*
+	*	@brief Converts a LaTeX snippet to a raw RGBA bitmap, in memory.
+	*
+	*	@details The HTML document is handed to wkhtmltoimage directly and
+	*			 the image is read back from its output buffer, so no file
+	*			 is touched and several instances can render concurrently.
+	*			 The image travels as an uncompressed BMP, which is much
+	*			 cheaper to produce and decode than a PNG.
+	*
+	*	@param latex The LaTeX snippet to render.
+	*
+	*	@param pixels Receives width * height RGBA8 pixels, row by row.
+	*
+	*	@param width Receives the width of the bitmap.
+	*
+	*	@param height Receives the height of the bitmap.
+	*
+	*	@throws ParseException If the parsing of the latex snippet failed.
+	*
+	*	@throws ConversionException If the conversion of the latex snippet
+	*							    to an image failed.
+	*
+	***************************************************************************/
+	
+	virtual void to_bitmap(const std::string& latex,
+						   std::vector<unsigned char>& pixels,
+						   int& width,
+						   int& height) const;
+	
 	/***********************************************************************//*!
 	*
 	*	@brief Adds additional CSS to the base-stylesheet.
@@ -518,11 +547,27 @@ protected:
 	
 	virtual std::string _escape(std::string source) const;
 	
+	/***********************************************************************//*!
+	*
+	*	@brief Returns the URL under which the stylesheet gets linked.
+	*
+	*	@details The HTML is handed to wkhtmltoimage as data, which has no
+	*			 location to resolve relative paths against, so relative
+	*			 stylesheet paths are made absolute (file:///).
+	*
+	***************************************************************************/
+	
+	virtual std::string _stylesheet_url() const;
+	
 	/***********************************************************************//*!
 	*
 	*	@brief Requests, initializes and returns a wkhtmltoimage converter.
 	*
+	*	@param html The HTML document to convert.
+	*
 	*	@param filepath The output file at which to store the converted file.
+	*					If empty, the output is kept in the converter's
+	*					buffer (see wkhtmltoimage_get_output()).
 	*
 	*	@param format The image-format to convert to.
 	*
@@ -531,13 +576,16 @@ protected:
 	***************************************************************************/
 	
 	virtual wkhtmltoimage_converter*
-	_new_converter(const std::string& filepath, ImageFormat format) const;
+	_new_converter(const std::string& html,
+				   const std::string& filepath,
+				   ImageFormat format) const;
 
 	/***********************************************************************//*!
 	*
 	*	@brief Helper method of _new_converter to handle wkhtmltoimage settings.
 	*
-	*	@param filepath The output file at which to store the converted file.
+	*	@param filepath The output file at which to store the converted file,
+	*					or empty to keep the output in memory.
 	*
 	*	@param format The image-format to convert to.
 	*
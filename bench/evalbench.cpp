@@ -0,0 +1,94 @@
+#include "interpolator.h"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <stdio.h>
+
+// compares the plain and compensated evaluation paths, in speed and in accuracy against
+// long double, on runge's function sampled at chebyshev nodes of increasing degree.
+
+using namespace finter;
+
+struct Mode
+{
+    const char*             name;
+    InterpolationPrecision  precision;
+    bool                    compensated;
+};
+
+static const uint32_t SAMPLES = 1 << 16;
+static const uint32_t REPEAT = 20;
+
+static void fill(Interpolation& _intp, uint32_t _n)
+{
+    for (uint32_t i = 0; i < _n; i++)
+    {
+        Vec2 p;
+        p.x = (float)cos(3.14159265358979 * (2 * i + 1) / (2 * _n));
+        p.y = 1.0f / (1.0f + 25.0f * p.x * p.x);
+        _intp.addDatapoint(p);
+    }
+}
+
+int main()
+{
+    const Mode modes[] = {
+        { "float",             Precision_Float,      false },
+        { "float compensated", Precision_Float,      true },
+        { "double",            Precision_Double,     false },
+        { "double compensated", Precision_Double,    true },
+    };
+    const InterpolationVariant variants[] = { Interpolation_Lagrange, Interpolation_NewtonFwd };
+    const char* variantNames[] = { "lagrange", "newton" };
+    const uint32_t degrees[] = { 10, 25, 50 };
+
+    std::vector<float> xs(SAMPLES);
+    std::vector<float> ys(SAMPLES);
+    std::vector<float> ref(SAMPLES);
+
+    for (uint32_t i = 0; i < SAMPLES; i++)
+    {
+        xs[i] = -1.0f + 2.0f * i / (SAMPLES - 1);
+    }
+
+    printf("%-9s %-4s %-20s %12s %12s\n", "variant", "n", "mode", "ns/value", "max error");
+
+    for (uint32_t v = 0; v < 2; v++)
+    {
+        for (uint32_t d = 0; d < sizeof(degrees) / sizeof(degrees[0]); d++)
+        {
+            Interpolation exact;
+            exact.setPrecision(Precision_LongDouble);
+            exact.setCompensated(true);
+            fill(exact, degrees[d]);
+            exact.evalMany(variants[v], xs.data(), ref.data(), SAMPLES);
+
+            for (uint32_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+            {
+                Interpolation intp;
+                intp.setPrecision(modes[m].precision);
+                intp.setCompensated(modes[m].compensated);
+                fill(intp, degrees[d]);
+
+                auto start = std::chrono::high_resolution_clock::now();
+                for (uint32_t r = 0; r < REPEAT; r++)
+                {
+                    intp.evalMany(variants[v], xs.data(), ys.data(), SAMPLES);
+                }
+                std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+                double err = 0.0;
+                for (uint32_t i = 0; i < SAMPLES; i++)
+                {
+                    err = fmax(err, fabs((double)ys[i] - ref[i]));
+                }
+
+                printf("%-9s %-4u %-20s %12.2f %12.3g\n", variantNames[v], degrees[d], modes[m].name,
+                    elapsed.count() / ((double)REPEAT * SAMPLES), err);
+            }
+        }
+    }
+
+    return 0;
+}
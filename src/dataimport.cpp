@@ -0,0 +1,297 @@
+#include "dataimport.h"
+#include "mappedfile.h"
+#include "math.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+
+#define IMPORT_CHUNKS_PER_THREAD 8
+#define IMPORT_MIN_CHUNK_BYTES (256 * 1024)
+
+namespace finter
+{
+    struct ImportChunk
+    {
+        size_t                          begin;                     // byte range of the file, whole lines for text.
+        size_t                          end;
+        std::vector<Vec2>               datapoints;
+        size_t                          errorPos;                  // offset of the first error in the file, SIZE_MAX if none.
+        const char*                     error;
+    };
+
+    // lines hold x and y in their first two columns, separated by a comma, a semicolon or
+    // blanks. other columns are ignored, and so are blank lines and '#' comments. a first line
+    // that doesn't start with a number is taken for a header.
+    static void parseText(const char* _data, ImportChunk& _chunk)
+    {
+        const char* p = _data + _chunk.begin;
+        const char* end = _data + _chunk.end;
+        const char* first = _data;
+        const char* q;
+        Vec2        point;
+
+        // utf-8 byte order mark.
+        if (0 == _chunk.begin && end - p >= 3 && 0 == memcmp(p, "\xEF\xBB\xBF", 3))
+        {
+            p += 3;
+            first = p;
+        }
+
+        while (p < end)
+        {
+            const char* line = p;
+            const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+            if (nullptr == lineEnd) lineEnd = end;
+
+            p = skipBlanks(p, lineEnd);
+
+            if (p < lineEnd && '#' != *p)
+            {
+                q = parseFloat(p, lineEnd, point.x);
+
+                if (nullptr == q && line == first)
+                {
+                    p = lineEnd + 1;
+                    continue;
+                }
+
+                // the separator, then y.
+                if (nullptr != q)
+                {
+                    p = skipBlanks(q, lineEnd);
+                    if (p < lineEnd && (',' == *p || ';' == *p)) p++;
+                    p = skipBlanks(p, lineEnd);
+
+                    q = p != q ? parseFloat(p, lineEnd, point.y) : nullptr;
+                }
+
+                if (nullptr != q && q < lineEnd && !isBlank(*q) && ',' != *q && ';' != *q)
+                {
+                    p = q;
+                    q = nullptr;
+                }
+
+                if (nullptr == q)
+                {
+                    _chunk.errorPos = p - _data;
+                    _chunk.error = "expected an x and a y value";
+                    return;
+                }
+
+                _chunk.datapoints.push_back(point);
+            }
+
+            p = lineEnd + 1;
+        }
+    }
+
+    template <typename T>
+    static void parseBinary(const uint8_t* _data, ImportChunk& _chunk)
+    {
+        const uint8_t* p = _data + _chunk.begin;
+        size_t         n = (_chunk.end - _chunk.begin) / (2 * sizeof(T));
+        T              pair[2];
+
+        _chunk.datapoints.resize(n);
+
+        // the x86 targets are little-endian, so the pairs are copied as they are.
+        for (size_t i = 0; i < n; i++, p += sizeof(pair))
+        {
+            memcpy(pair, p, sizeof(pair));
+
+            if (!std::isfinite(pair[0]) || !std::isfinite(pair[1]))
+            {
+                _chunk.errorPos = p - _data;
+                _chunk.error = "value is not a finite number";
+                return;
+            }
+
+            _chunk.datapoints[i].x = (float)pair[0];
+            _chunk.datapoints[i].y = (float)pair[1];
+        }
+    }
+
+    static ImportFormat formatFromPath(const char* _path)
+    {
+        const char* ext = strrchr(_path, '.');
+
+        if (nullptr != ext && (0 == strcmp(ext, ".f32") || 0 == strcmp(ext, ".bin")))
+            return Import_Float;
+
+        if (nullptr != ext && 0 == strcmp(ext, ".f64"))
+            return Import_Double;
+
+        return Import_Text;
+    }
+
+    DataImporter::DataImporter() : running(false), finished(false), progress(0.0f)
+    {
+        result.seconds = 0.0;
+    }
+
+    DataImporter::~DataImporter()
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+
+    bool DataImporter::load(const char* _path, ImportFormat _format, ThreadPool& _pool, std::vector<Vec2>& _outData, std::string& _outError, std::atomic<float>* _outProgress)
+    {
+        MappedFile file;
+        char       buff[255];
+
+        if (!file.open(_path))
+        {
+            _outError = "could not open the file";
+            return false;
+        }
+
+        if (Import_Auto == _format)
+            _format = formatFromPath(_path);
+
+        const char* data = (const char*)file.getData();
+        size_t      size = file.getSize();
+        size_t      pairSize = Import_Float == _format ? 2 * sizeof(float) : 2 * sizeof(double);
+
+        if (Import_Text != _format && 0 != size % pairSize)
+        {
+            snprintf(buff, sizeof(buff), "the file size is not a multiple of %zu bytes (an x, y pair)", pairSize);
+            _outError = buff;
+            return false;
+        }
+
+        // a few chunks per thread balance the load, as long as they aren't too small to be worth it.
+        size_t                   chunkCount = std::max<size_t>(1, std::min<size_t>(_pool.getThreadCount() * IMPORT_CHUNKS_PER_THREAD, size / IMPORT_MIN_CHUNK_BYTES));
+        std::vector<ImportChunk> chunks(chunkCount);
+        std::atomic<uint32_t>    done(0);
+        size_t                   from = 0;
+
+        for (size_t c = 0; c < chunkCount; c++)
+        {
+            size_t to = c + 1 == chunkCount ? size : std::max(from, size * (c + 1) / chunkCount);
+
+            if (Import_Text == _format)
+            {
+                const char* nl = to < size ? (const char*)memchr(data + to, '\n', size - to) : nullptr;
+                to = nullptr != nl ? nl - data + 1 : size;
+            }
+            else
+            {
+                to -= to % pairSize;
+            }
+
+            chunks[c].begin = from;
+            chunks[c].end = to;
+            chunks[c].errorPos = SIZE_MAX;
+            chunks[c].error = nullptr;
+            from = to;
+        }
+
+        _pool.parallelFor((uint32_t)chunkCount, [&](uint32_t _c)
+        {
+            ImportChunk& chunk = chunks[_c];
+
+            if (Import_Text == _format)
+            {
+                // there are no more points than lines, counting those is cheap next to parsing them.
+                chunk.datapoints.reserve(std::count(data + chunk.begin, data + chunk.end, '\n') + 1);
+                parseText(data, chunk);
+            }
+            else if (Import_Float == _format)
+            {
+                parseBinary<float>(file.getData(), chunk);
+            }
+            else
+            {
+                parseBinary<double>(file.getData(), chunk);
+            }
+
+            uint32_t n = ++done;
+            if (_outProgress) *_outProgress = (float)n / chunkCount;
+        });
+
+        // report the first error in the file, along with its line for text.
+        for (size_t c = 0; c < chunkCount; c++)
+        {
+            if (nullptr == chunks[c].error) continue;
+
+            if (Import_Text == _format)
+            {
+                size_t line = 1 + std::count(data, data + chunks[c].errorPos, '\n');
+                snprintf(buff, sizeof(buff), "line %zu: %s", line, chunks[c].error);
+            }
+            else
+            {
+                snprintf(buff, sizeof(buff), "pair %zu: %s", chunks[c].errorPos / pairSize, chunks[c].error);
+            }
+
+            _outError = buff;
+            return false;
+        }
+
+        std::vector<size_t> offsets(chunkCount + 1, 0);
+        for (size_t c = 0; c < chunkCount; c++)
+        {
+            offsets[c + 1] = offsets[c] + chunks[c].datapoints.size();
+        }
+
+        _outData.resize(offsets[chunkCount]);
+
+        _pool.parallelFor((uint32_t)chunkCount, [&](uint32_t _c)
+        {
+            if (chunks[_c].datapoints.size() > 0)
+                memcpy(&_outData[offsets[_c]], chunks[_c].datapoints.data(), chunks[_c].datapoints.size() * sizeof(Vec2));
+
+            chunks[_c].datapoints = std::vector<Vec2>();
+        });
+
+        return true;
+    }
+
+    bool DataImporter::start(const char* _path, ImportFormat _format)
+    {
+        if (running) return false;
+
+        if (thread.joinable())
+            thread.join();
+
+        running = true;
+        finished = false;
+        progress = 0.0f;
+
+        result.path = _path;
+        result.datapoints.clear();
+        result.error.clear();
+
+        thread = std::thread([this, _format]()
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            if (!DataImporter::load(result.path.c_str(), _format, pool, result.datapoints, result.error, &progress))
+                result.datapoints = std::vector<Vec2>();
+
+            result.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            finished = true;
+        });
+
+        return true;
+    }
+
+    bool DataImporter::poll(ImportResult& _out)
+    {
+        if (!finished) return false;
+
+        thread.join();
+        _out = std::move(result);
+
+        result = ImportResult();
+        result.seconds = 0.0;
+        finished = false;
+        running = false;
+
+        return true;
+    }
+}
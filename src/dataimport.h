@@ -0,0 +1,64 @@
+#ifndef DATAIMPORT_H_
+#define DATAIMPORT_H_
+
+#include "threadpool.h"
+#include "vec2.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace finter
+{
+    enum ImportFormat
+    {
+        Import_Auto,                                               // from the file extension (.f32/.bin, .f64, text otherwise).
+        Import_Text,                                               // csv/tsv, x and y in the first two columns of each line.
+        Import_Float,                                              // raw little-endian float32 x, y pairs.
+        Import_Double,                                             // raw little-endian float64 x, y pairs.
+    };
+
+    struct ImportResult
+    {
+        std::string                     path;
+        std::vector<Vec2>               datapoints;
+        std::string                     error;                     // empty if the import succeeded.
+        double                          seconds;
+    };
+
+    // loads datapoints from a file. the file is memory mapped and cut in chunks (at line
+    // boundaries for text) which are parsed in parallel, then concatenated in order.
+    class DataImporter
+    {
+    public:
+                                        DataImporter();
+                                        ~DataImporter();
+
+        // imports _path synchronously on _pool, adding the chunks done so far to _outProgress (0 to 1).
+        static bool                     load(const char* _path, ImportFormat _format, ThreadPool& _pool, std::vector<Vec2>& _outData, std::string& _outError, std::atomic<float>* _outProgress = nullptr);
+
+        // starts importing _path on a background thread. returns false if an import is already running.
+        bool                            start(const char* _path, ImportFormat _format);
+
+        // takes the result of the import once it finished. returns false until then.
+        bool                            poll(ImportResult& _out);
+
+        inline bool                     isRunning() { return running; }
+        inline float                    getProgress() { return progress; }
+
+    private:
+                                        DataImporter(const DataImporter&) = delete;
+        DataImporter&                   operator=(const DataImporter&) = delete;
+
+        ThreadPool                      pool;                      // separate from the renderer's, so sampling the graph never waits on an import.
+        std::thread                     thread;
+        std::atomic<bool>               running;
+        std::atomic<bool>               finished;
+        std::atomic<float>              progress;
+        ImportResult                    result;                    // owned by the import thread until finished is set.
+    };
+}
+
+#endif // DATAIMPORT_H_
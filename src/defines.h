@@ -8,6 +8,14 @@
 #define LEFT_PANEL_HEIGHT VIEWPORT_HEIGHT
 
 #define GRAPH_HEIGHT 500
+#define GRAPH_CURVES 4
+#define GRAPH_PARALLEL_MIN_WORK (32 * 1000)
+#define GRAPH_BASE_COLUMNS_PER_SAMPLE 2
+#define GRAPH_REFINE_BUDGET (8 * 1024)
+#define GRAPH_PIXEL_TOLERANCE 0.5f
+#define GRAPH_OFFSCREEN_LIMIT 4.0f
+#define GRAPH_MAX_DATAPOINTS (8 * 1024)
+#define SAMPLER_CACHE_LEVELS 8
 
 #define MIDDLE_PANEL_WIDTH (VIEWPORT_WIDTH - LEFT_PANEL_WIDTH)
 #define MIDDLE_PANEL_HEIGHT (GRAPH_HEIGHT + 10)
@@ -15,11 +23,19 @@
 #define BOTTOM_PANEL_WIDTH MIDDLE_PANEL_WIDTH
 #define BOTTOM_PANEL_HEIGHT VIEWPORT_HEIGHT - MIDDLE_PANEL_HEIGHT
 
-#define INPUT_BUFFER_LEN 1024 * 5
 #define INTERPOLATION_NAME_LEN 256
+#define INTERPOLATION_NO_DATAPOINT UINT32_MAX
 
 #define MAX_DATAPOINTS 256
+#define MAX_POLYNOMIAL_DATAPOINTS 2048
 #define TEXTURES_CACHE_SIZE 255
+#define LATEX_STYLESHEET "katex/katex.min.css"
+#define LATEX_REQUEST_TTL 2
+#define LATEX_PLACEHOLDER_HEIGHT 40
+
+#define FORMULA_CACHE_MAX_BYTES (64 * 1024 * 1024)
+#define FORMULA_CACHE_FLUSH_INTERVAL 16
+#define FORMULA_CACHE_MAX_DIMENSION 16384
 
 #define ZERO_MEM(_var)                                                                  \
     memset(&(_var), 0, sizeof((_var)));
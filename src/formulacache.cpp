@@ -0,0 +1,383 @@
+#include "formulacache.h"
+#include "mappedfile.h"
+#include "defines.h"
+
+#include <algorithm>
+#include <string.h>
+
+#define FORMULA_CACHE_MAGIC "FFCI"
+#define FORMULA_CACHE_VERSION 1
+
+namespace finter
+{
+    FormulaCache::FormulaCache(const std::string& _dir, uint64_t _maxBytes)
+    {
+        indexPath = _dir + "formulas.idx";
+        packPath = _dir + "formulas.pack";
+        pack = nullptr;
+        packBytes = 0;
+        liveBytes = 0;
+        maxBytes = _maxBytes;
+        tick = 0;
+        unsaved = 0;
+        touched = false;
+
+        pack = fopen(packPath.c_str(), "r+b");
+        if (nullptr == pack)
+        {
+            pack = fopen(packPath.c_str(), "w+b");
+        }
+
+        if (nullptr != pack)
+        {
+            fileSeek(pack, 0, SEEK_END);
+            packBytes = fileTell(pack);
+            readIndex();
+        }
+    }
+
+    FormulaCache::~FormulaCache()
+    {
+        if (unsaved > 0 || touched) flush();
+        if (nullptr != pack) fclose(pack);
+    }
+
+    uint64_t FormulaCache::key(const std::string& _latex, const std::string& _stylesheet, const std::string& _css)
+    {
+        // 64 bit FNV-1a over every input, separated so ("ab", "c") and ("a", "bc") differ
+        uint64_t h = 14695981039346656037ULL;
+        const std::string* parts[] = { &_latex, &_stylesheet, &_css };
+
+        for (uint32_t p = 0; p < 3; p++)
+        {
+            for (auto it = parts[p]->begin(); it != parts[p]->end(); ++it)
+            {
+                h = (h ^ (uint8_t)*it) * 1099511628211ULL;
+            }
+            h = (h ^ 0xff) * 1099511628211ULL;
+        }
+
+        return (h ^ FORMULA_CACHE_VERSION) * 1099511628211ULL;
+    }
+
+    bool FormulaCache::load(uint64_t _key, std::vector<uint8_t>& _outPixels, int32_t& _outW, int32_t& _outH)
+    {
+        auto it = entries.find(_key);
+        if (it == entries.end()) return false;
+
+        Entry& e = it->second;
+
+        // nothing gets allocated for an entry that can't be right.
+        bool ok = FormulaCache::isValid(e);
+
+        if (ok)
+        {
+            buff.resize(e.size);
+            _outPixels.resize((size_t)e.w * e.h * 4);
+        }
+
+        if (!ok
+            || !fileSeek(pack, e.offset)
+            || e.size != fread(buff.data(), 1, e.size, pack)
+            || !FormulaCache::decode(buff.data(), e.size, _outPixels.data(), e.w * e.h))
+        {
+            // corrupted, forget about it so it gets rendered (and stored) again
+            liveBytes -= e.size;
+            entries.erase(it);
+            unsaved++;
+            return false;
+        }
+
+        e.lastUsed = tick++;
+        touched = true;
+        _outW = e.w;
+        _outH = e.h;
+
+        return true;
+    }
+
+    void FormulaCache::store(uint64_t _key, const std::vector<uint8_t>& _pixels, int32_t _w, int32_t _h)
+    {
+        if (nullptr == pack || entries.find(_key) != entries.end()) return;
+        if (_w <= 0 || _h <= 0 || _w > FORMULA_CACHE_MAX_DIMENSION || _h > FORMULA_CACHE_MAX_DIMENSION) return;
+
+        FormulaCache::encode(_pixels.data(), _w * _h, buff);
+        if (buff.size() > maxBytes) return;
+
+        if (!fileSeek(pack, packBytes)
+            || buff.size() != fwrite(buff.data(), 1, buff.size(), pack))
+        {
+            return;
+        }
+
+        Entry e;
+        e.key = _key;
+        e.offset = packBytes;
+        e.size = buff.size();
+        e.w = _w;
+        e.h = _h;
+        e.reserved = 0;
+        e.lastUsed = tick++;
+        entries.insert(std::pair<uint64_t, Entry>(_key, e));
+
+        packBytes += e.size;
+        liveBytes += e.size;
+
+        if (liveBytes > maxBytes)
+        {
+            evict();
+            compact();
+            flush();
+        }
+        else if (++unsaved >= FORMULA_CACHE_FLUSH_INTERVAL)
+        {
+            flush();
+        }
+    }
+
+    void FormulaCache::flush()
+    {
+        if (nullptr == pack) return;
+        fflush(pack);
+
+        // write aside and swap it in, so a crash never leaves a half written index behind
+        std::string tmpPath = indexPath + ".tmp";
+        FILE* f = fopen(tmpPath.c_str(), "wb");
+        if (nullptr == f) return;
+
+        IndexHeader header;
+        memcpy(header.magic, FORMULA_CACHE_MAGIC, sizeof(header.magic));
+        header.version = FORMULA_CACHE_VERSION;
+        header.count = entries.size();
+        header.entrySize = sizeof(Entry);
+
+        bool ok = 1 == fwrite(&header, sizeof(header), 1, f);
+        for (auto it = entries.begin(); ok && it != entries.end(); ++it)
+        {
+            ok = 1 == fwrite(&it->second, sizeof(Entry), 1, f);
+        }
+        ok = 0 == fclose(f) && ok;
+
+        if (ok)
+        {
+            remove(indexPath.c_str());
+            ok = 0 == rename(tmpPath.c_str(), indexPath.c_str());
+        }
+
+        if (ok)
+        {
+            unsaved = 0;
+            touched = false;
+        }
+    }
+
+    // a truncated or corrupted index can claim anything, so entries are checked before a
+    // single byte gets allocated for them: the bitmap must fit a texture, and its blob the pack
+    // (and the encoding, which takes at most 5 bytes per pixel).
+    bool FormulaCache::isValid(const Entry& _e)
+    {
+        return _e.w > 0 && _e.h > 0
+            && _e.w <= FORMULA_CACHE_MAX_DIMENSION && _e.h <= FORMULA_CACHE_MAX_DIMENSION
+            && _e.size > 0 && _e.size <= maxBytes
+            && _e.size <= (uint64_t)_e.w * _e.h * 5
+            && _e.offset <= packBytes && _e.size <= packBytes - _e.offset;
+    }
+
+    void FormulaCache::readIndex()
+    {
+        MappedFile file;
+        if (!file.open(indexPath.c_str()) || file.getSize() < sizeof(IndexHeader)) return;
+
+        IndexHeader header;
+        memcpy(&header, file.getData(), sizeof(header));
+
+        if (0 != memcmp(header.magic, FORMULA_CACHE_MAGIC, sizeof(header.magic))
+            || FORMULA_CACHE_VERSION != header.version
+            || sizeof(Entry) != header.entrySize
+            || file.getSize() < sizeof(IndexHeader) + (uint64_t)header.count * sizeof(Entry))
+        {
+            return;
+        }
+
+        const uint8_t* p = file.getData() + sizeof(IndexHeader);
+        Entry e;
+
+        entries.reserve(header.count);
+        for (uint32_t i = 0; i < header.count; i++, p += sizeof(Entry))
+        {
+            memcpy(&e, p, sizeof(Entry));
+
+            // drop whatever is corrupted or points past the end of the pack (e.g. it was
+            // truncated), the next flush writes the index without them.
+            if (!FormulaCache::isValid(e))
+            {
+                unsaved++;
+                continue;
+            }
+
+            entries.insert(std::pair<uint64_t, Entry>(e.key, e));
+            liveBytes += e.size;
+            tick = std::max(tick, e.lastUsed + 1);
+        }
+    }
+
+    void FormulaCache::evict()
+    {
+        std::vector<Entry*> lru;
+        lru.reserve(entries.size());
+
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+            lru.push_back(&it->second);
+        }
+
+        std::sort(lru.begin(), lru.end(), [](Entry* _a, Entry* _b) { return _a->lastUsed < _b->lastUsed; });
+
+        // leave some headroom so we don't end up compacting on every store
+        uint64_t target = maxBytes / 4 * 3;
+        std::vector<uint64_t> victims;
+
+        for (auto it = lru.begin(); it != lru.end() && liveBytes > target; ++it)
+        {
+            liveBytes -= (*it)->size;
+            victims.push_back((*it)->key);
+        }
+
+        for (auto it = victims.begin(); it != victims.end(); ++it)
+        {
+            entries.erase(*it);
+        }
+    }
+
+    void FormulaCache::compact()
+    {
+        std::string tmpPath = packPath + ".tmp";
+        FILE* f = fopen(tmpPath.c_str(), "w+b");
+        if (nullptr == f) return;
+
+        // copy the live blobs in pack order, so the old pack is read sequentially
+        std::vector<Entry*> live;
+        live.reserve(entries.size());
+
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+            live.push_back(&it->second);
+        }
+
+        std::sort(live.begin(), live.end(), [](Entry* _a, Entry* _b) { return _a->offset < _b->offset; });
+
+        uint64_t offset = 0;
+        bool ok = true;
+
+        for (auto it = live.begin(); ok && it != live.end(); ++it)
+        {
+            buff.resize((*it)->size);
+
+            ok = fileSeek(pack, (*it)->offset)
+                && buff.size() == fread(buff.data(), 1, buff.size(), pack)
+                && buff.size() == fwrite(buff.data(), 1, buff.size(), f);
+
+            (*it)->offset = offset;
+            offset += (*it)->size;
+        }
+
+        if (!ok)
+        {
+            // the old pack is still intact, but the offsets are not. start over.
+            fclose(f);
+            remove(tmpPath.c_str());
+
+            entries.clear();
+            liveBytes = 0;
+            return;
+        }
+
+        fclose(f);
+        fclose(pack);
+        remove(packPath.c_str());
+        rename(tmpPath.c_str(), packPath.c_str());
+
+        pack = fopen(packPath.c_str(), "r+b");
+        packBytes = offset;
+        liveBytes = offset;
+
+        if (nullptr == pack)
+        {
+            entries.clear();
+            liveBytes = 0;
+            packBytes = 0;
+        }
+    }
+
+    // the encoding works on whole RGBA pixels. a control byte c < 128 is followed by
+    // c + 1 literal pixels, c >= 128 by a single pixel repeated c - 126 times. rendered
+    // formulas are mostly flat background, so this shrinks them a lot for very little cpu.
+    void FormulaCache::encode(const uint8_t* _rgba, uint32_t _pixels, std::vector<uint8_t>& _out)
+    {
+        const uint8_t* px = _rgba;
+        uint32_t i = 0;
+        uint32_t run;
+
+        _out.clear();
+        _out.reserve(_pixels);
+
+        while (i < _pixels)
+        {
+            run = 1;
+            while (i + run < _pixels && run < 129 && 0 == memcmp(px + (i + run) * 4, px + i * 4, 4)) run++;
+
+            if (run >= 2)
+            {
+                _out.push_back((uint8_t)(128 + run - 2));
+                _out.insert(_out.end(), px + i * 4, px + i * 4 + 4);
+                i += run;
+            }
+            else
+            {
+                uint32_t start = i;
+
+                while (i < _pixels && i - start < 128)
+                {
+                    if (i + 1 < _pixels && 0 == memcmp(px + (i + 1) * 4, px + i * 4, 4)) break;
+                    i++;
+                }
+
+                _out.push_back((uint8_t)(i - start - 1));
+                _out.insert(_out.end(), px + start * 4, px + i * 4);
+            }
+        }
+    }
+
+    bool FormulaCache::decode(const uint8_t* _in, size_t _len, uint8_t* _rgba, uint32_t _pixels)
+    {
+        const uint8_t* end = _in + _len;
+        uint32_t o = 0;
+        uint32_t n;
+
+        while (_in < end)
+        {
+            uint8_t c = *_in++;
+
+            if (c < 128)
+            {
+                n = c + 1;
+                if (o + n > _pixels || (size_t)(end - _in) < n * 4) return false;
+
+                memcpy(_rgba + o * 4, _in, n * 4);
+                _in += n * 4;
+            }
+            else
+            {
+                n = c - 126;
+                if (o + n > _pixels || end - _in < 4) return false;
+
+                for (uint32_t k = 0; k < n; k++) memcpy(_rgba + (o + k) * 4, _in, 4);
+                _in += 4;
+            }
+
+            o += n;
+        }
+
+        return o == _pixels;
+    }
+}
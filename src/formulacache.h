@@ -0,0 +1,75 @@
+#ifndef FORMULACACHE_H_
+#define FORMULACACHE_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace finter
+{
+    // persistent, size-bounded cache of rendered formula bitmaps.
+    //
+    // bitmaps are run-length encoded and appended to a single pack file, while a small
+    // index file (mapped at startup) tells where each of them lives. entries are keyed
+    // by a hash of everything that affects the rendered image, and the least recently
+    // used ones get evicted (and the pack compacted) once the size budget is exceeded.
+    class FormulaCache
+    {
+    public:
+                                        FormulaCache(const std::string& _dir, uint64_t _maxBytes);
+                                        ~FormulaCache();
+
+        static uint64_t                 key(const std::string& _latex, const std::string& _stylesheet, const std::string& _css);
+
+        bool                            load(uint64_t _key, std::vector<uint8_t>& _outPixels, int32_t& _outW, int32_t& _outH);
+        void                            store(uint64_t _key, const std::vector<uint8_t>& _pixels, int32_t _w, int32_t _h);
+
+        // writes the index to disk.
+        void                            flush();
+
+    private:
+        struct IndexHeader
+        {
+            char                        magic[4];
+            uint32_t                    version;
+            uint32_t                    count;
+            uint32_t                    entrySize;
+        };
+
+        struct Entry
+        {
+            uint64_t                    key;
+            uint64_t                    offset;                     // position of the encoded bitmap in the pack file.
+            uint32_t                    size;                       // length of the encoded bitmap.
+            uint32_t                    w;
+            uint32_t                    h;
+            uint32_t                    reserved;
+            uint64_t                    lastUsed;
+        };
+
+        std::string                     indexPath;
+        std::string                     packPath;
+        FILE*                           pack;
+        uint64_t                        packBytes;                  // size of the pack file (live + dead blobs).
+        uint64_t                        liveBytes;                  // bytes taken by the blobs still in the index.
+        uint64_t                        maxBytes;
+        uint64_t                        tick;
+        uint32_t                        unsaved;                    // entries stored since the last flush.
+        bool                            touched;                    // hits since the last flush changed the lru order, saved on exit.
+
+        std::unordered_map<uint64_t, Entry> entries;
+        std::vector<uint8_t>            buff;
+
+        bool                            isValid(const Entry& _e);
+        void                            readIndex();
+        void                            evict();
+        void                            compact();
+
+        static void                     encode(const uint8_t* _rgba, uint32_t _pixels, std::vector<uint8_t>& _out);
+        static bool                     decode(const uint8_t* _in, size_t _len, uint8_t* _rgba, uint32_t _pixels);
+    };
+}
+
+#endif // FORMULACACHE_H_
@@ -1,100 +1,1082 @@
 #include "interpolator.h"
 #include "math.h"
-
+#include "simd.h"
+
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <type_traits>
+#include <utility>
 #include <limits.h>
 #include <string.h>
 #include <inttypes.h>
+#include <float.h>
 
 namespace finter
 {
+    // revisions are unique across every interpolation, so whatever caches things computed
+    // from one can key them by revision alone.
+    static std::atomic<uint64_t> lastRevision(0);
+
+    inline static uint64_t nextRevision()
+    {
+        return ++lastRevision;
+    }
+
     Interpolation::Interpolation()
     {
         ZERO_MEM(name);
+        datapointSelected = INTERPOLATION_NO_DATAPOINT;
+        datapointsEquidistant = true;
+        datapointsSpacing = 0.0f;
+        precision = Precision_Float;
+        compensated = false;
+        chebyshevEnabled = false;
+        splineBoundary = Spline_Natural;
+        splineSlopeStart = 0.0f;
+        splineSlopeEnd = 0.0f;
+        monomialsEnabled = false;
+        revision = nextRevision();
     }
 
     Interpolation::~Interpolation()
     {
     }
 
-    bool Interpolation::parseData(const char * _inBuff, std::vector<ImVec2>& _outData)
+    static_assert(std::is_nothrow_move_constructible<Interpolation>::value, "the container would copy interpolations when it grows");
+
+    bool Interpolation::parseData(const char* _inBuff, std::vector<Vec2>& _outData, size_t* _outErrorPos)
+    {
+        return parseData(_inBuff, strlen(_inBuff), _outData, _outErrorPos);
+    }
+
+    bool Interpolation::parseData(const char* _inBuff, size_t _len, std::vector<Vec2>& _outData, size_t* _outErrorPos)
     {
         const char* p = _inBuff;
-        char        buff[25];
-        uint32_t    buffPos = 0;
-        ImVec2      point;
+        const char* end = _inBuff + _len;
+        const char* q;
+        size_t      prevCount = _outData.size();
+        bool        valid = true;
+        Vec2        point;
+
+        // every pair but the last ends with a separator, so counting them bounds the room needed.
+        _outData.reserve(prevCount + 1 + std::count_if(p, end, [](char _c) { return ';' == _c || '\n' == _c; }));
+
+        while (valid && p < end)
+        {
+            p = skipBlanks(p, end);
+
+            // empty pair, e.g. a trailing separator or a blank line.
+            if (p == end) break;
+            if (';' == *p || '\n' == *p)
+            {
+                p++;
+                continue;
+            }
+
+            valid = nullptr != (q = parseFloat(p, end, point.x));
+            if (!valid) break;
+
+            p = skipBlanks(q, end);
+            valid = p < end && ',' == *p;
+            if (!valid) break;
+
+            p = skipBlanks(p + 1, end);
+            valid = nullptr != (q = parseFloat(p, end, point.y));
+            if (!valid) break;
+
+            p = skipBlanks(q, end);
+            valid = p == end || ';' == *p || '\n' == *p;
+            if (!valid) break;
+
+            _outData.push_back(point);
+        }
+
+        if (!valid)
+        {
+            _outData.resize(prevCount);
+            if (_outErrorPos) *_outErrorPos = p - _inBuff;
+        }
+
+        return valid;
+    }
+
+    bool Interpolation::updateSpacing()
+    {
+        // the nodes are equidistant if each one lands on x0 + i*h, up to the rounding of the
+        // inputs (0.1, 0.2, 0.3 aren't exactly evenly spaced as floats). a few ulps of the
+        // largest node are allowed, which no one could tell apart on the graph.
+        float    prevSpacing = datapointsSpacing;
+        uint32_t n = datapoints.size();
+
+        datapointsEquidistant = n < 2;
+        datapointsSpacing = 0.0f;
+
+        if (n >= 2)
+        {
+            double x0 = datapoints[0].x;
+            double h = (datapoints[n - 1].x - x0) / (n - 1);
+            double tol = 8.0 * FLT_EPSILON * std::max(fabs(x0), fabs((double)datapoints[n - 1].x));
+
+            datapointsEquidistant = 0.0 != h;
+            for (uint32_t i = 1; datapointsEquidistant && i < n - 1; i++)
+            {
+                datapointsEquidistant = fabs(datapoints[i].x - (x0 + i * h)) <= tol;
+            }
+
+            if (datapointsEquidistant)
+                datapointsSpacing = (float)h;
+        }
+
+        return prevSpacing != datapointsSpacing;
+    }
+
+    void Interpolation::recalculate()
+    {
+        revision = nextRevision();
+        updateSpacing();
+        recalculateDiffs();
+        recalculateWeights();
+        recalculateSpline();
+
+        if (monomialsEnabled)
+            recalculateMonomials();
+
+        if (chebyshevEnabled)
+            recalculateChebyshev();
+    }
+
+    void Interpolation::recalculateDiffs()
+    {
+        withState([&](auto& _s)
+        {
+            if (hasPolynomial())
+                Newton::calculateDiffs(datapoints, _s.diffs, datapointsSpacing);
+            else
+                _s.diffs = {};
+        });
+    }
+
+    void Interpolation::recalculateWeights()
+    {
+        withState([&](auto& _s)
+        {
+            if (hasPolynomial())
+                _s.weightsScale = Lagrange::calculateWeights(datapoints, _s.weights);
+            else
+                _s.weights = {};
+        });
+    }
+
+    void Interpolation::recalculateMonomials()
+    {
+        monomialsEnabled = true;
+        withState([&](auto& _s)
+        {
+            if (hasPolynomial())
+                Newton::calculateMonomials(datapoints, _s.diffs, true, _s.monomials);
+            else
+                _s.monomials = {};
+        });
+    }
+
+    void Interpolation::recalculateChebyshev()
+    {
+        chebyshevEnabled = true;
+        withState([&](auto& _s)
+        {
+            if (hasPolynomial())
+                Chebyshev::fit(datapoints, _s.weights, _s.chebyshev);
+            else
+                _s.chebyshev.coeffs = {};
+        });
+    }
+
+    void Interpolation::recalculateSpline()
+    {
+        withState([&](auto& _s) { Spline::build(datapoints, splineBoundary, splineSlopeStart, splineSlopeEnd, fabs(datapointsSpacing), _s.spline); });
+    }
+
+    void Interpolation::setSplineBoundary(SplineBoundary _boundary, float _slopeStart, float _slopeEnd)
+    {
+        if (_boundary == splineBoundary && _slopeStart == splineSlopeStart && _slopeEnd == splineSlopeEnd) return;
+
+        revision = nextRevision();
+        splineBoundary = _boundary;
+        splineSlopeStart = _slopeStart;
+        splineSlopeEnd = _slopeEnd;
+        recalculateSpline();
+    }
+
+    void Interpolation::setChebyshev(bool _enabled)
+    {
+        if (_enabled == chebyshevEnabled) return;
+
+        revision = nextRevision();
+        chebyshevEnabled = _enabled;
+
+        if (chebyshevEnabled)
+            recalculateChebyshev();
+    }
+
+    void Interpolation::setPrecision(InterpolationPrecision _precision)
+    {
+        if (_precision == precision) return;
+
+        // drop the state of the previous precision, it won't be kept up to date anymore.
+        stateF = InterpolationState<float>();
+        stateD = InterpolationState<double>();
+        stateLD = InterpolationState<long double>();
+
+        precision = _precision;
+        recalculate();
+    }
+
+    void Interpolation::setCompensated(bool _compensated)
+    {
+        if (_compensated == compensated) return;
+
+        // nothing to recalculate, but the values change.
+        compensated = _compensated;
+        revision = nextRevision();
+    }
+
+    float Interpolation::eval(InterpolationVariant _variant, float _x)
+    {
+        float r = 0.0f;
+        bool  fwd = Interpolation_NewtonFwd == _variant;
+
+        if (Interpolation_None == _variant) return r;
+        if (Interpolation_Spline != _variant && !hasPolynomial()) return std::numeric_limits<float>::quiet_NaN();
+
+        withState([&](auto& _s)
+        {
+            if (Interpolation_Spline == _variant)
+                r = (float)Spline::eval(_s.spline, _x);
+            else if (chebyshevEnabled)
+                r = (float)Chebyshev::eval(_s.chebyshev, _x);
+            else if (Interpolation_Lagrange == _variant)
+                r = (float)(compensated ? Lagrange::evalCompensated(datapoints, _x, _s.weights) : Lagrange::eval(datapoints, _x, _s.weights));
+            else
+                r = (float)(compensated ? Newton::evalCompensated(datapoints, _x, fwd, _s.diffs) : Newton::eval(datapoints, _x, fwd, _s.diffs));
+        });
+
+        return r;
+    }
+
+    float Interpolation::evalMonomials(float _x)
+    {
+        float r = 0.0f;
+        withState([&](auto& _s) { r = (float)Newton::evalMonomials(_s.monomials, _x); });
+        return r;
+    }
+
+    void Interpolation::addDatapoint(const Vec2& _p)
+    {
+        datapoints.push_back(_p);
+        if (!hasPolynomial())
+        {
+            recalculate();
+            return;
+        }
+
+        revision = nextRevision();
+        bool respaced = updateSpacing();
+
+        withState([&](auto& _s)
+        {
+            if (respaced)
+                Newton::calculateDiffs(datapoints, _s.diffs, datapointsSpacing);
+            else
+                Newton::appendDiffs(datapoints, _s.diffs);
+
+            if (!Lagrange::appendWeight(datapoints, _s.weights, _s.weightsScale))
+                recalculateWeights();
+        });
+
+        recalculateSpline();
 
-        while (*p)
+        if (monomialsEnabled)
+            recalculateMonomials();
+
+        if (chebyshevEnabled)
+            recalculateChebyshev();
+    }
+
+    void Interpolation::setDatapointAt(uint32_t _index, const Vec2& _p)
+    {
+        float prevX = datapoints[_index].x;
+        datapoints[_index] = _p;
+        if (!hasPolynomial())
+        {
+            recalculate();
+            return;
+        }
+
+        revision = nextRevision();
+        bool respaced = updateSpacing();
+
+        withState([&](auto& _s)
+        {
+            if (respaced)
+                Newton::calculateDiffs(datapoints, _s.diffs, datapointsSpacing);
+            else
+                Newton::updateDiffsAt(datapoints, _s.diffs, _index);
+
+            if (prevX != _p.x && !Lagrange::updateWeightAt(datapoints, _s.weights, _index, prevX, _s.weightsScale))
+                recalculateWeights();
+        });
+
+        recalculateSpline();
+
+        if (monomialsEnabled)
+            recalculateMonomials();
+
+        if (chebyshevEnabled)
+            recalculateChebyshev();
+    }
+
+    void Interpolation::removeDatapointAt(uint32_t _index)
+    {
+        float removedX = datapoints[_index].x;
+        datapoints.erase(datapoints.begin() + _index);
+
+        if (datapointSelected == _index)
+            datapointSelected = INTERPOLATION_NO_DATAPOINT;
+        else if (datapointSelected > _index && INTERPOLATION_NO_DATAPOINT != datapointSelected)
+            datapointSelected--;
+
+        // dropping below the limit has no previous state to update.
+        if (datapoints.size() >= MAX_POLYNOMIAL_DATAPOINTS)
+        {
+            recalculate();
+            return;
+        }
+
+        revision = nextRevision();
+        bool respaced = updateSpacing();
+
+        withState([&](auto& _s)
+        {
+            if (respaced)
+                Newton::calculateDiffs(datapoints, _s.diffs, datapointsSpacing);
+            else
+                Newton::removeDiffsAt(datapoints, _s.diffs, _index);
+
+            if (!Lagrange::removeWeightAt(datapoints, _s.weights, _index, removedX, _s.weightsScale))
+                recalculateWeights();
+        });
+
+        recalculateSpline();
+
+        if (monomialsEnabled)
+            recalculateMonomials();
+
+        if (chebyshevEnabled)
+            recalculateChebyshev();
+    }
+
+    void Interpolation::clearDatapoints()
+    {
+        datapoints.clear();
+        datapointSelected = INTERPOLATION_NO_DATAPOINT;
+        recalculate();
+    }
+
+    void Interpolation::evalMany(InterpolationVariant _variant, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax)
+    {
+        if (Interpolation_None != _variant && Interpolation_Spline != _variant && !hasPolynomial())
+        {
+            std::fill(_ys, _ys + _n, std::numeric_limits<float>::quiet_NaN());
+            if (_outMin) *_outMin = FLT_MAX;
+            if (_outMax) *_outMax = -FLT_MAX;
+            return;
+        }
+
+        if (chebyshevEnabled && Interpolation_None != _variant && Interpolation_Spline != _variant)
+        {
+            withState([&](auto& _s) { Chebyshev::evalMany(_s.chebyshev, _xs, _ys, _n, _outMin, _outMax); });
+            return;
+        }
+
+        switch (_variant)
+        {
+        case Interpolation_Lagrange:
+            withState([&](auto& _s) { Lagrange::evalMany(datapoints, _s.weights, compensated, _xs, _ys, _n, _outMin, _outMax); });
+            break;
+
+        case Interpolation_NewtonFwd:
+        case Interpolation_NewtonBwd:
+            withState([&](auto& _s) { Newton::evalMany(datapoints, _s.diffs, Interpolation_NewtonFwd == _variant, compensated, _xs, _ys, _n, _outMin, _outMax); });
+            break;
+
+        case Interpolation_Spline:
+            withState([&](auto& _s) { Spline::evalMany(_s.spline, _xs, _ys, _n, _outMin, _outMax); });
+            break;
+
+        default:
+            memset(_ys, 0, _n * sizeof(float));
+            if (_outMin) *_outMin = _n > 0 ? 0.0f : FLT_MAX;
+            if (_outMax) *_outMax = _n > 0 ? 0.0f : -FLT_MAX;
+            break;
+        }
+    }
+
+    // batched evaluation kernels. the polynomial is walked once per block of abscissas,
+    // broadcasting each node/coefficient to every lane. avx handles 8 values per
+    // iteration, sse 4, and whatever is left over goes through the scalar path.
+    // min/max are accumulated in the same pass, ignoring NaNs.
+
+    inline static void minMax(float _y, float& _min, float& _max)
+    {
+        _min = _y < _min ? _y : _min;
+        _max = _y > _max ? _y : _max;
+    }
+
+#if FINTER_SIMD_X86
+    FINTER_TARGET_AVX
+    static size_t barycentricAvx(std::vector<Vec2>& _dp, std::vector<float>& _weights, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 vmin = _mm256_set1_ps(_min);
+        __m256 vmax = _mm256_set1_ps(_max);
+        __m256 x, y, d, t, num, den, onNode;
+        float  lanes[8];
+        size_t i = 0;
+
+        for (; i + 8 <= _n; i += 8)
         {
-            if (*p == ',' || *p == ';')
+            x = _mm256_loadu_ps(_xs + i);
+            num = zero;
+            den = zero;
+            onNode = zero;
+
+            for (uint32_t j = 0; j < _dp.size(); j++)
             {
-                buff[buffPos] = '\0';
-                buffPos = 0;
+                d = _mm256_sub_ps(x, _mm256_set1_ps(_dp[j].x));
+                onNode = _mm256_or_ps(onNode, _mm256_cmp_ps(d, zero, _CMP_EQ_OQ));
+                t = _mm256_div_ps(_mm256_set1_ps(_weights[j]), d);
+                num = _mm256_add_ps(num, _mm256_mul_ps(t, _mm256_set1_ps(_dp[j].y)));
+                den = _mm256_add_ps(den, t);
             }
 
-            if (*p == ',')
+            y = _mm256_div_ps(num, den);
+            _mm256_storeu_ps(_ys + i, y);
+
+            if (int32_t mask = _mm256_movemask_ps(onNode))
             {
-                point.x = strtof(buff, NULL);
+                for (uint32_t k = 0; k < 8; k++)
+                    if (mask & (1 << k)) _ys[i + k] = Lagrange::eval(_dp, _xs[i + k], _weights);
+
+                y = _mm256_loadu_ps(_ys + i);
             }
-            else if (*p == ';')
+
+            vmin = _mm256_min_ps(y, vmin);
+            vmax = _mm256_max_ps(y, vmax);
+        }
+
+        _mm256_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 8; k++) _min = fmin(_min, lanes[k]);
+        _mm256_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 8; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
+    }
+
+    static size_t barycentricSse(std::vector<Vec2>& _dp, std::vector<float>& _weights, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        __m128 vmin = _mm_set1_ps(_min);
+        __m128 vmax = _mm_set1_ps(_max);
+        __m128 x, y, d, t, num, den, onNode;
+        float  lanes[4];
+        size_t i = 0;
+
+        for (; i + 4 <= _n; i += 4)
+        {
+            x = _mm_loadu_ps(_xs + i);
+            num = zero;
+            den = zero;
+            onNode = zero;
+
+            for (uint32_t j = 0; j < _dp.size(); j++)
             {
-                // end of ordered pair
-                point.y = strtof(buff, NULL);
-                _outData.push_back(point);
+                d = _mm_sub_ps(x, _mm_set1_ps(_dp[j].x));
+                onNode = _mm_or_ps(onNode, _mm_cmpeq_ps(d, zero));
+                t = _mm_div_ps(_mm_set1_ps(_weights[j]), d);
+                num = _mm_add_ps(num, _mm_mul_ps(t, _mm_set1_ps(_dp[j].y)));
+                den = _mm_add_ps(den, t);
             }
-            else
+
+            y = _mm_div_ps(num, den);
+            _mm_storeu_ps(_ys + i, y);
+
+            if (int32_t mask = _mm_movemask_ps(onNode))
             {
-                buff[buffPos++] = *p;
+                for (uint32_t k = 0; k < 4; k++)
+                    if (mask & (1 << k)) _ys[i + k] = Lagrange::eval(_dp, _xs[i + k], _weights);
+
+                y = _mm_loadu_ps(_ys + i);
             }
 
-            p++;
+            vmin = _mm_min_ps(y, vmin);
+            vmax = _mm_max_ps(y, vmax);
         }
 
-        if (buffPos != 0)
+        _mm_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 4; k++) _min = fmin(_min, lanes[k]);
+        _mm_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 4; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
+    }
+
+    FINTER_TARGET_AVX
+    static size_t hornerAvx(std::vector<float>& _coeffs, std::vector<float>& _nodes, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        __m256 vmin = _mm256_set1_ps(_min);
+        __m256 vmax = _mm256_set1_ps(_max);
+        __m256 x, y;
+        float  lanes[8];
+        size_t i = 0;
+        int32_t last = _coeffs.size() - 1;
+
+        for (; i + 8 <= _n; i += 8)
         {
-            buff[buffPos] = '\0';
-            point.y = strtof(buff, NULL);
-            _outData.push_back(point);
+            x = _mm256_loadu_ps(_xs + i);
+            y = _mm256_set1_ps(_coeffs[last]);
+
+            for (int32_t k = last - 1; k >= 0; k--)
+            {
+                y = _mm256_mul_ps(y, _mm256_sub_ps(x, _mm256_set1_ps(_nodes[k])));
+                y = _mm256_add_ps(y, _mm256_set1_ps(_coeffs[k]));
+            }
+
+            _mm256_storeu_ps(_ys + i, y);
+            vmin = _mm256_min_ps(y, vmin);
+            vmax = _mm256_max_ps(y, vmax);
         }
 
-        return true;
+        _mm256_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 8; k++) _min = fmin(_min, lanes[k]);
+        _mm256_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 8; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
     }
 
-    void Interpolation::recalculateDiffs()
+    static size_t hornerSse(std::vector<float>& _coeffs, std::vector<float>& _nodes, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
     {
-        Newton::calculateDiffs(datapoints, diffs);
+        __m128 vmin = _mm_set1_ps(_min);
+        __m128 vmax = _mm_set1_ps(_max);
+        __m128 x, y;
+        float  lanes[4];
+        size_t i = 0;
+        int32_t last = _coeffs.size() - 1;
+
+        for (; i + 4 <= _n; i += 4)
+        {
+            x = _mm_loadu_ps(_xs + i);
+            y = _mm_set1_ps(_coeffs[last]);
+
+            for (int32_t k = last - 1; k >= 0; k--)
+            {
+                y = _mm_mul_ps(y, _mm_sub_ps(x, _mm_set1_ps(_nodes[k])));
+                y = _mm_add_ps(y, _mm_set1_ps(_coeffs[k]));
+            }
+
+            _mm_storeu_ps(_ys + i, y);
+            vmin = _mm_min_ps(y, vmin);
+            vmax = _mm_max_ps(y, vmax);
+        }
+
+        _mm_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 4; k++) _min = fmin(_min, lanes[k]);
+        _mm_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 4; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
     }
 
-    float Lagrange::lx(std::vector<ImVec2>& _dp, uint32_t _i, float _x)
+    // compensated horner, see Newton::evalCompensated(). every twoSum/twoProd is spelled out,
+    // the products are split with 4097 = 2^12 + 1 (half of the 24 bit float mantissa).
+    FINTER_TARGET_AVX
+    static size_t hornerCompAvx(std::vector<float>& _coeffs, std::vector<float>& _nodes, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
     {
-        float dividend = 1;
-        float divisor = 1;
+        const __m256 splitter = _mm256_set1_ps(4097.0f);
+        __m256 vmin = _mm256_set1_ps(_min);
+        __m256 vmax = _mm256_set1_ps(_max);
+        __m256 x, y, c, xk, ck, d, ed, p, ep, z, t, yh, yl, dh, dl;
+        float  lanes[8];
+        size_t i = 0;
+        int32_t last = _coeffs.size() - 1;
+
+        for (; i + 8 <= _n; i += 8)
+        {
+            x = _mm256_loadu_ps(_xs + i);
+            y = _mm256_set1_ps(_coeffs[last]);
+            c = _mm256_setzero_ps();
 
-        for (uint32_t index = 0; index < _dp.size(); index++)
+            for (int32_t k = last - 1; k >= 0; k--)
+            {
+                xk = _mm256_set1_ps(_nodes[k]);
+                ck = _mm256_set1_ps(_coeffs[k]);
+
+                // d + ed = x - xk
+                d = _mm256_sub_ps(x, xk);
+                z = _mm256_sub_ps(d, x);
+                ed = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_sub_ps(d, z)), _mm256_add_ps(xk, z));
+
+                // p + ep = y * d
+                p = _mm256_mul_ps(y, d);
+                t = _mm256_mul_ps(splitter, y);
+                yh = _mm256_sub_ps(t, _mm256_sub_ps(t, y));
+                yl = _mm256_sub_ps(y, yh);
+                t = _mm256_mul_ps(splitter, d);
+                dh = _mm256_sub_ps(t, _mm256_sub_ps(t, d));
+                dl = _mm256_sub_ps(d, dh);
+                ep = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(p, _mm256_mul_ps(yh, dh)), _mm256_mul_ps(yl, dh)), _mm256_mul_ps(yh, dl));
+                ep = _mm256_sub_ps(_mm256_mul_ps(yl, dl), ep);
+
+                c = _mm256_add_ps(_mm256_mul_ps(c, d), _mm256_add_ps(_mm256_mul_ps(y, ed), ep));
+
+                // y + (error into c) = p + ck
+                y = _mm256_add_ps(p, ck);
+                z = _mm256_sub_ps(y, p);
+                c = _mm256_add_ps(c, _mm256_add_ps(_mm256_sub_ps(p, _mm256_sub_ps(y, z)), _mm256_sub_ps(ck, z)));
+            }
+
+            y = _mm256_add_ps(y, c);
+            _mm256_storeu_ps(_ys + i, y);
+            vmin = _mm256_min_ps(y, vmin);
+            vmax = _mm256_max_ps(y, vmax);
+        }
+
+        _mm256_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 8; k++) _min = fmin(_min, lanes[k]);
+        _mm256_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 8; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
+    }
+
+    static size_t hornerCompSse(std::vector<float>& _coeffs, std::vector<float>& _nodes, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        const __m128 splitter = _mm_set1_ps(4097.0f);
+        __m128 vmin = _mm_set1_ps(_min);
+        __m128 vmax = _mm_set1_ps(_max);
+        __m128 x, y, c, xk, ck, d, ed, p, ep, z, t, yh, yl, dh, dl;
+        float  lanes[4];
+        size_t i = 0;
+        int32_t last = _coeffs.size() - 1;
+
+        for (; i + 4 <= _n; i += 4)
         {
-            if (index != _i)
+            x = _mm_loadu_ps(_xs + i);
+            y = _mm_set1_ps(_coeffs[last]);
+            c = _mm_setzero_ps();
+
+            for (int32_t k = last - 1; k >= 0; k--)
             {
-                dividend *= (_x - _dp[index].x);
-                divisor *= (_dp[_i].x - _dp[index].x);
+                xk = _mm_set1_ps(_nodes[k]);
+                ck = _mm_set1_ps(_coeffs[k]);
+
+                d = _mm_sub_ps(x, xk);
+                z = _mm_sub_ps(d, x);
+                ed = _mm_sub_ps(_mm_sub_ps(x, _mm_sub_ps(d, z)), _mm_add_ps(xk, z));
+
+                p = _mm_mul_ps(y, d);
+                t = _mm_mul_ps(splitter, y);
+                yh = _mm_sub_ps(t, _mm_sub_ps(t, y));
+                yl = _mm_sub_ps(y, yh);
+                t = _mm_mul_ps(splitter, d);
+                dh = _mm_sub_ps(t, _mm_sub_ps(t, d));
+                dl = _mm_sub_ps(d, dh);
+                ep = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(p, _mm_mul_ps(yh, dh)), _mm_mul_ps(yl, dh)), _mm_mul_ps(yh, dl));
+                ep = _mm_sub_ps(_mm_mul_ps(yl, dl), ep);
+
+                c = _mm_add_ps(_mm_mul_ps(c, d), _mm_add_ps(_mm_mul_ps(y, ed), ep));
+
+                y = _mm_add_ps(p, ck);
+                z = _mm_sub_ps(y, p);
+                c = _mm_add_ps(c, _mm_add_ps(_mm_sub_ps(p, _mm_sub_ps(y, z)), _mm_sub_ps(ck, z)));
             }
+
+            y = _mm_add_ps(y, c);
+            _mm_storeu_ps(_ys + i, y);
+            vmin = _mm_min_ps(y, vmin);
+            vmax = _mm_max_ps(y, vmax);
         }
-        return dividend / divisor;
+
+        _mm_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 4; k++) _min = fmin(_min, lanes[k]);
+        _mm_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 4; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
     }
 
-    float Lagrange::eval(std::vector<ImVec2>& _dp, float _x)
+    // newton-gregory form on equidistant nodes, see Newton::eval(). _steps[k] = -k (forward) or
+    // k (backward) and _recips[k] = 1 / (k + 1), s = (x - _origin) / h.
+    FINTER_TARGET_AVX
+    static size_t gregoryAvx(std::vector<float>& _diffs, std::vector<float>& _steps, std::vector<float>& _recips, float _origin, float _invStep, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
     {
-        if (0 == _dp.size()) return 0.0f;
+        const __m256 origin = _mm256_set1_ps(_origin);
+        const __m256 invStep = _mm256_set1_ps(_invStep);
+        __m256 vmin = _mm256_set1_ps(_min);
+        __m256 vmax = _mm256_set1_ps(_max);
+        __m256 s, y;
+        float  lanes[8];
+        size_t i = 0;
+        int32_t last = _diffs.size() - 1;
+
+        for (; i + 8 <= _n; i += 8)
+        {
+            s = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(_xs + i), origin), invStep);
+            y = _mm256_set1_ps(_diffs[last]);
 
-        float r = 0.0f;
+            for (int32_t k = last - 1; k >= 0; k--)
+            {
+                y = _mm256_mul_ps(_mm256_mul_ps(y, _mm256_add_ps(s, _mm256_set1_ps(_steps[k]))), _mm256_set1_ps(_recips[k]));
+                y = _mm256_add_ps(y, _mm256_set1_ps(_diffs[k]));
+            }
+
+            _mm256_storeu_ps(_ys + i, y);
+            vmin = _mm256_min_ps(y, vmin);
+            vmax = _mm256_max_ps(y, vmax);
+        }
+
+        _mm256_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 8; k++) _min = fmin(_min, lanes[k]);
+        _mm256_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 8; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
+    }
+
+    static size_t gregorySse(std::vector<float>& _diffs, std::vector<float>& _steps, std::vector<float>& _recips, float _origin, float _invStep, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        const __m128 origin = _mm_set1_ps(_origin);
+        const __m128 invStep = _mm_set1_ps(_invStep);
+        __m128 vmin = _mm_set1_ps(_min);
+        __m128 vmax = _mm_set1_ps(_max);
+        __m128 s, y;
+        float  lanes[4];
+        size_t i = 0;
+        int32_t last = _diffs.size() - 1;
+
+        for (; i + 4 <= _n; i += 4)
+        {
+            s = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_xs + i), origin), invStep);
+            y = _mm_set1_ps(_diffs[last]);
+
+            for (int32_t k = last - 1; k >= 0; k--)
+            {
+                y = _mm_mul_ps(_mm_mul_ps(y, _mm_add_ps(s, _mm_set1_ps(_steps[k]))), _mm_set1_ps(_recips[k]));
+                y = _mm_add_ps(y, _mm_set1_ps(_diffs[k]));
+            }
+
+            _mm_storeu_ps(_ys + i, y);
+            vmin = _mm_min_ps(y, vmin);
+            vmax = _mm_max_ps(y, vmax);
+        }
+
+        _mm_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 4; k++) _min = fmin(_min, lanes[k]);
+        _mm_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 4; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
+    }
+
+    // clenshaw recurrence for the chebyshev series, see Chebyshev::eval(). every step depends on
+    // the previous one, so the avx kernel runs two blocks side by side to hide the latency.
+    FINTER_TARGET_AVX
+    static size_t clenshawAvx(std::vector<float>& _coeffs, float _mid, float _scale, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        const __m256 mid = _mm256_set1_ps(_mid);
+        const __m256 scale = _mm256_set1_ps(_scale);
+        __m256 vmin = _mm256_set1_ps(_min);
+        __m256 vmax = _mm256_set1_ps(_max);
+        __m256 ta, tb, a1, a2, b1, b2, c, tmp, y;
+        float  lanes[8];
+        size_t i = 0;
+        int32_t last = _coeffs.size() - 1;
+
+        for (; i + 16 <= _n; i += 16)
+        {
+            ta = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(_xs + i), mid), scale);
+            tb = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(_xs + i + 8), mid), scale);
+            a1 = a2 = b1 = b2 = _mm256_setzero_ps();
+
+            for (int32_t k = last; k > 0; k--)
+            {
+                c = _mm256_set1_ps(_coeffs[k]);
+
+                tmp = a1;
+                a1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(ta, ta), a1), a2), c);
+                a2 = tmp;
+
+                tmp = b1;
+                b1 = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(tb, tb), b1), b2), c);
+                b2 = tmp;
+            }
+
+            c = _mm256_set1_ps(_coeffs[0]);
+
+            y = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(ta, a1), a2), c);
+            _mm256_storeu_ps(_ys + i, y);
+            vmin = _mm256_min_ps(y, vmin);
+            vmax = _mm256_max_ps(y, vmax);
+
+            y = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(tb, b1), b2), c);
+            _mm256_storeu_ps(_ys + i + 8, y);
+            vmin = _mm256_min_ps(y, vmin);
+            vmax = _mm256_max_ps(y, vmax);
+        }
+
+        _mm256_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 8; k++) _min = fmin(_min, lanes[k]);
+        _mm256_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 8; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
+    }
+
+    static size_t clenshawSse(std::vector<float>& _coeffs, float _mid, float _scale, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        __m128 vmin = _mm_set1_ps(_min);
+        __m128 vmax = _mm_set1_ps(_max);
+        __m128 t, t2, b1, b2, tmp, y;
+        float  lanes[4];
+        size_t i = 0;
+        int32_t last = _coeffs.size() - 1;
+
+        for (; i + 4 <= _n; i += 4)
+        {
+            t = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(_xs + i), _mm_set1_ps(_mid)), _mm_set1_ps(_scale));
+            t2 = _mm_add_ps(t, t);
+            b1 = _mm_setzero_ps();
+            b2 = _mm_setzero_ps();
+
+            for (int32_t k = last; k > 0; k--)
+            {
+                tmp = b1;
+                b1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(t2, b1), b2), _mm_set1_ps(_coeffs[k]));
+                b2 = tmp;
+            }
+
+            y = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(t, b1), b2), _mm_set1_ps(_coeffs[0]));
+            _mm_storeu_ps(_ys + i, y);
+            vmin = _mm_min_ps(y, vmin);
+            vmax = _mm_max_ps(y, vmax);
+        }
+
+        _mm_storeu_ps(lanes, vmin);
+        for (uint32_t k = 0; k < 4; k++) _min = fmin(_min, lanes[k]);
+        _mm_storeu_ps(lanes, vmax);
+        for (uint32_t k = 0; k < 4; k++) _max = fmax(_max, lanes[k]);
+
+        return i;
+    }
+#endif
+
+    // vectorized part of the batched evaluation, returning how many values it took care of.
+    // the kernels are single precision only, the other precisions (and every precision on
+    // targets without kernels) go through the scalar path, and so does the compensated
+    // barycentric formula.
+    template <typename T>
+    inline static size_t barycentricMany(std::vector<Vec2>&, std::vector<T>&, bool, const float*, float*, size_t, float&, float&)
+    {
+        return 0;
+    }
+
+#if FINTER_SIMD_X86
+    inline static size_t barycentricMany(std::vector<Vec2>& _dp, std::vector<float>& _weights, bool _compensated, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        static const bool hasAvx = cpuHasAvx();
+        size_t i = 0;
+
+        if (_compensated) return 0;
+
+        if (hasAvx)
+            i = barycentricAvx(_dp, _weights, _xs, _ys, _n, _min, _max);
+
+        i += barycentricSse(_dp, _weights, _xs + i, _ys + i, _n - i, _min, _max);
+
+        return i;
+    }
+#endif
+
+    template <typename T>
+    inline static size_t hornerMany(std::vector<T>&, std::vector<T>&, bool, const float*, float*, size_t, float&, float&)
+    {
+        return 0;
+    }
+
+#if FINTER_SIMD_X86
+    inline static size_t hornerMany(std::vector<float>& _coeffs, std::vector<float>& _nodes, bool _compensated, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        static const bool hasAvx = cpuHasAvx();
+        size_t i = 0;
+
+        if (_compensated)
+        {
+            if (hasAvx)
+                i = hornerCompAvx(_coeffs, _nodes, _xs, _ys, _n, _min, _max);
+
+            i += hornerCompSse(_coeffs, _nodes, _xs + i, _ys + i, _n - i, _min, _max);
+        }
+        else
+        {
+            if (hasAvx)
+                i = hornerAvx(_coeffs, _nodes, _xs, _ys, _n, _min, _max);
+
+            i += hornerSse(_coeffs, _nodes, _xs + i, _ys + i, _n - i, _min, _max);
+        }
+
+        return i;
+    }
+#endif
+
+    template <typename T>
+    T Lagrange::eval(std::vector<Vec2>& _dp, float _x, std::vector<T>& _weights)
+    {
+        if (0 == _dp.size()) return 0;
+
+        // second (true) form of the barycentric formula:
+        //   P(x) = sum(w_i * y_i / (x - x_i)) / sum(w_i / (x - x_i))
+        T num = 0;
+        T den = 0;
+        T t;
 
         for (uint32_t i = 0; i < _dp.size(); i++)
         {
-            r += _dp[i].y * lx(_dp, i, _x);
+            t = (T)_x - _dp[i].x;
+
+            // x lands exactly on a node, the formula above is undefined there.
+            if (t == 0) return _dp[i].y;
+
+            t = _weights[i] / t;
+            num += t * _dp[i].y;
+            den += t;
         }
 
-        return r;
+        return num / den;
+    }
+
+    template <typename T>
+    T Lagrange::evalCompensated(std::vector<Vec2>& _dp, float _x, std::vector<T>& _weights)
+    {
+        if (0 == _dp.size()) return 0;
+
+        // same as eval(), but the node differences are taken exactly (as d + ed) and both
+        // sums are accumulated with error-free transformations, their rounding errors summed
+        // up on the side and added back at the end.
+        T num = 0;
+        T numErr = 0;
+        T den = 0;
+        T denErr = 0;
+        T d, ed, t, p, e;
+
+        for (uint32_t i = 0; i < _dp.size(); i++)
+        {
+            twoSum((T)_x, (T)-_dp[i].x, d, ed);
+            if (d == 0) return _dp[i].y;
+
+            // w / (d + ed) ~= w / d * (1 - ed / d)
+            t = _weights[i] / d;
+            t -= t * (ed / d);
+
+            twoProd(t, (T)_dp[i].y, p, e);
+            numErr += e;
+            twoSum(num, p, num, e);
+            numErr += e;
+
+            twoSum(den, t, den, e);
+            denErr += e;
+        }
+
+        return (num + numErr) / (den + denErr);
     }
 
-    void Lagrange::latexFormula(std::vector<ImVec2>& _dp, std::string& _out)
+    template <typename T>
+    inline static size_t gregoryMany(std::vector<T>&, std::vector<T>&, std::vector<T>&, float, float, const float*, float*, size_t, float&, float&)
+    {
+        return 0;
+    }
+
+#if FINTER_SIMD_X86
+    inline static size_t gregoryMany(std::vector<float>& _diffs, std::vector<float>& _steps, std::vector<float>& _recips, float _origin, float _invStep, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        static const bool hasAvx = cpuHasAvx();
+        size_t i = 0;
+
+        if (hasAvx)
+            i = gregoryAvx(_diffs, _steps, _recips, _origin, _invStep, _xs, _ys, _n, _min, _max);
+
+        i += gregorySse(_diffs, _steps, _recips, _origin, _invStep, _xs + i, _ys + i, _n - i, _min, _max);
+
+        return i;
+    }
+#endif
+
+    template <typename T>
+    inline static size_t clenshawMany(ChebyshevSeries<T>&, const float*, float*, size_t, float&, float&)
+    {
+        return 0;
+    }
+
+#if FINTER_SIMD_X86
+    inline static size_t clenshawMany(ChebyshevSeries<float>& _series, const float* _xs, float* _ys, size_t _n, float& _min, float& _max)
+    {
+        static const bool hasAvx = cpuHasAvx();
+        size_t i = 0;
+
+        float mid = 0.5f * (_series.xMin + _series.xMax);
+        float scale = _series.xMax > _series.xMin ? 2.0f / (_series.xMax - _series.xMin) : 0.0f;
+
+        if (hasAvx)
+            i = clenshawAvx(_series.coeffs, mid, scale, _xs, _ys, _n, _min, _max);
+
+        i += clenshawSse(_series.coeffs, mid, scale, _xs + i, _ys + i, _n - i, _min, _max);
+
+        return i;
+    }
+#endif
+
+    float Lagrange::eval(std::vector<Vec2>& _dp, float _x)
+    {
+        std::vector<float> weights;
+        Lagrange::calculateWeights(_dp, weights);
+
+        return Lagrange::eval(_dp, _x, weights);
+    }
+
+    template <typename T>
+    void Lagrange::evalMany(std::vector<Vec2>& _dp, std::vector<T>& _weights, bool _compensated, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax)
+    {
+        float  min = FLT_MAX;
+        float  max = -FLT_MAX;
+        size_t i = 0;
+
+        if (_dp.size() > 0)
+            i = barycentricMany(_dp, _weights, _compensated, _xs, _ys, _n, min, max);
+
+        for (; i < _n; i++)
+        {
+            _ys[i] = (float)(_compensated ? Lagrange::evalCompensated(_dp, _xs[i], _weights) : Lagrange::eval(_dp, _xs[i], _weights));
+            minMax(_ys[i], min, max);
+        }
+
+        if (_outMin) *_outMin = min;
+        if (_outMax) *_outMax = max;
+    }
+
+    void Lagrange::latexFormula(std::vector<Vec2>& _dp, std::string& _out)
     {
         static char buff[255];
         char s;
@@ -110,98 +1092,345 @@ namespace finter
         }
     }
 
-    void Lagrange::latexPx(std::vector<ImVec2>& _dp, std::string& _out)
+    void Lagrange::latexPx(std::vector<Vec2>& _dp, std::string& _out)
+    {
+        static char buff[255];
+        float v;
+        char  s;
+
+        _out = "P(x) = ";
+
+        for (uint32_t i = 0; i < _dp.size(); i++)
+        {
+            simplifySigns(true, _dp[i].y, &s, &v);
+            if (i == 0 && s == '+') s = ' ';
+
+            snprintf(buff, sizeof(buff), "%c %.4g \\cdot L_{%" PRIu32 "}(x)", s, v, i);
+            _out.append(buff);
+        }
+    }
+
+    void Lagrange::latexLx(std::vector<Vec2>& _dp, uint32_t _i, std::string& _out)
     {
         static char buff[255];
         float v;
         char  s;
 
-        _out = "P(x) = ";
+        static std::string tmp;
+        tmp.reserve(2500);
+        tmp = "{";
+
+        snprintf(buff, sizeof(buff), "L_{%" PRIu32 "}(x) = ", _i);
+        _out = std::string(buff);
+        _out.reserve(2500);
+        _out.append("{{");
+
+        for (uint32_t index = 0; index < _dp.size(); index++)
+        {
+            if (index != _i)
+            {
+                simplifySigns(false, _dp[index].x, &s, &v);
+                snprintf(buff, sizeof(buff), "(x  %c %.4g)", s, v);
+                _out.append(buff);
+
+                simplifySigns(false, _dp[index].x, &s, &v);
+                snprintf(buff, sizeof(buff), "(%.4g %c %.4g)", _dp[_i].x, s, v);
+                tmp.append(buff);
+            }
+        }
+
+        tmp.append("}");
+        _out.append("} \\above{1pt} ");
+        _out.append(tmp);
+        _out.append("}");
+    }
+
+    template <typename T>
+    T Lagrange::calculateWeights(std::vector<Vec2>& _dp, std::vector<T>& _outWeights)
+    {
+        _outWeights.resize(_dp.size());
+        if (0 == _dp.size()) return 1;
+
+        // w_i = 1 / prod(x_i - x_j) overflows quickly for wide ranges. since any common
+        // factor cancels out in the barycentric formula, every difference is divided by 
+        // a quarter of the interval length (the capacity of the interval) to keep
+        // the products within range.
+        float xMin = _dp[0].x;
+        float xMax = _dp[0].x;
+        for (uint32_t i = 1; i < _dp.size(); i++)
+        {
+            xMin = fmin(xMin, _dp[i].x);
+            xMax = fmax(xMax, _dp[i].x);
+        }
+        T scale = xMax > xMin ? 4 / ((T)xMax - xMin) : 1;
+
+        for (uint32_t i = 0; i < _dp.size(); i++)
+        {
+            T prod = 1;
+
+            for (uint32_t j = 0; j < _dp.size(); j++)
+            {
+                if (j != i)
+                {
+                    prod *= ((T)_dp[i].x - _dp[j].x) * scale;
+                }
+            }
+
+            _outWeights[i] = 1 / prod;
+        }
+
+        return scale;
+    }
+
+    // the incremental updates below multiply the factors of the affected node in or out of
+    // every weight, which is O(n). they keep the scale of the last full calculation, so if 
+    // the nodes end up far outside of it a weight may overflow or vanish, in which case
+    // they return false and the caller should fall back to calculateWeights().
+
+    template <typename T>
+    inline static bool weightsUsable(std::vector<T>& _weights)
+    {
+        for (uint32_t i = 0; i < _weights.size(); i++)
+        {
+            if (0 == _weights[i] || !std::isfinite(_weights[i])) return false;
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    bool Lagrange::appendWeight(std::vector<Vec2>& _dp, std::vector<T>& _weights, T _scale)
+    {
+        uint32_t last = _dp.size() - 1;
+        T        xNew = _dp[last].x;
+        T        prod = 1;
+        T        d;
+
+        _weights.resize(_dp.size());
+
+        for (uint32_t i = 0; i < last; i++)
+        {
+            d = (_dp[i].x - xNew) * _scale;
+            _weights[i] /= d;
+            prod *= -d;
+        }
+        _weights[last] = 1 / prod;
+
+        return weightsUsable(_weights);
+    }
+
+    template <typename T>
+    bool Lagrange::removeWeightAt(std::vector<Vec2>& _dp, std::vector<T>& _weights, uint32_t _index, float _removedX, T _scale)
+    {
+        _weights.erase(_weights.begin() + _index);
+
+        for (uint32_t i = 0; i < _dp.size(); i++)
+        {
+            _weights[i] *= ((T)_dp[i].x - _removedX) * _scale;
+        }
+
+        return weightsUsable(_weights);
+    }
+
+    template <typename T>
+    bool Lagrange::updateWeightAt(std::vector<Vec2>& _dp, std::vector<T>& _weights, uint32_t _index, float _prevX, T _scale)
+    {
+        T xNew = _dp[_index].x;
+        T prod = 1;
+        T d;
+
+        for (uint32_t i = 0; i < _dp.size(); i++)
+        {
+            if (i != _index)
+            {
+                d = (_dp[i].x - xNew) * _scale;
+                _weights[i] *= ((T)_dp[i].x - _prevX) * _scale / d;
+                prod *= -d;
+            }
+        }
+        _weights[_index] = 1 / prod;
+
+        return weightsUsable(_weights);
+    }
+
+    template <typename T>
+    T Newton::eval(std::vector<Vec2>& _dp, float _x, bool _fwd, DiffTable<T>& _diffs)
+    {
+        if (0 == _dp.size()) return 0;
+
+        uint32_t last = _diffs.count - 1;
+        T        r;
+
+        if (0 != _diffs.step)
+        {
+            // newton-gregory form over s = (x - x0) / h. as x - x(k) = (s - k) h, the powers of h
+            // and the factorials cancel out of the nesting and the finite differences d_k are used
+            // as they are: P = d0 + s/1 * (d1 + (s - 1)/2 * (d2 + ...)). backwards the nodes are
+            // x(n-1) - k h, so s is taken from the last one and k changes sign.
+            uint32_t n = _diffs.count;
+            T        s = ((T)_x - _dp[_fwd ? 0 : n - 1].x) / _diffs.step;
+
+            r = _diffs.raw(last, _fwd ? 0 : n - 1 - last);
+
+            for (int32_t k = last - 1; k >= 0; k--)
+            {
+                r = r * (_fwd ? s - k : s + k) / (k + 1) + _diffs.raw(k, _fwd ? 0 : n - 1 - k);
+            }
+
+            return r;
+        }
+
+        // nested multiplication (horner's scheme) over the newton form:
+        //   P(x) = c0 + (x - x0) * (c1 + (x - x1) * (c2 + ... (x - x(n-2)) * c(n-1)))
+        r = _diffs.coeff(last, _fwd);
+
+        for (int32_t i = last - 1; i >= 0; i--)
+        {
+            r = r * ((T)_x - _dp[_fwd ? i : _dp.size() - 1 - i].x) + _diffs.coeff(i, _fwd);
+        }
+
+        return r;
+    }
+
+    template <typename T>
+    T Newton::evalCompensated(std::vector<Vec2>& _dp, float _x, bool _fwd, DiffTable<T>& _diffs)
+    {
+        if (0 == _dp.size()) return 0;
 
-        for (uint32_t i = 0; i < _dp.size(); i++)
+        // compensated horner scheme (graillat, langlois, louvet): the rounding errors of the
+        // subtraction, product and sum of every step are recovered exactly and run through
+        // a second horner scheme of their own, which is added to the result at the end.
+        uint32_t last = _diffs.count - 1;
+        T        r = _diffs.coeff(last, _fwd);
+        T        c = 0;
+        T        d, ed, p, ep, es;
+
+        for (int32_t i = last - 1; i >= 0; i--)
         {
-            simplifySigns(true, _dp[i].y, &s, &v);
-            if (i == 0 && s == '+') s = ' ';
+            twoSum((T)_x, (T)-_dp[_fwd ? i : _dp.size() - 1 - i].x, d, ed);
+            twoProd(r, d, p, ep);
+            c = c * d + (r * ed + ep);
 
-            snprintf(buff, sizeof(buff), "%c %.4g \\cdot L_{%" PRIu32 "}(x)", s, v, i);
-            _out.append(buff);
+            twoSum(p, _diffs.coeff(i, _fwd), r, es);
+            c += es;
         }
+
+        return r + c;
     }
 
-    void Lagrange::latexLx(std::vector<ImVec2>& _dp, uint32_t _i, std::string& _out)
+    float Newton::eval(std::vector<Vec2>& _dp, float _x, bool _fwd)
     {
-        static char buff[255];
-        float v;
-        char  s;
+        DiffTable<float> diffs;
+        Newton::calculateDiffs(_dp, diffs);
 
-        static std::string tmp;
-        tmp.reserve(2500);
-        tmp = "{";
+        return Newton::eval(_dp, _x, _fwd, diffs);
+    }
 
-        snprintf(buff, sizeof(buff), "L_{%" PRIu32 "}(x) = ", _i);
-        _out = std::string(buff);
-        _out.reserve(2500);
-        _out.append("{{");
+    template <typename T>
+    void Newton::evalMany(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, bool _compensated, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax)
+    {
+        float  min = FLT_MAX;
+        float  max = -FLT_MAX;
+        size_t i = 0;
 
-        for (uint32_t index = 0; index < _dp.size(); index++)
+        if (_dp.size() > 0)
         {
-            if (index != _i)
+            // gather the coefficients and nodes of the chosen form into contiguous arrays
+            // so the kernels only have to broadcast them.
+            std::vector<T> coeffs(_diffs.count);
+            std::vector<T> nodes(_diffs.count);
+
+            if (0 != _diffs.step && !_compensated)
             {
-                simplifySigns(false, _dp[index].x, &s, &v);
-                snprintf(buff, sizeof(buff), "(x  %c %.4g)", s, v);
-                _out.append(buff);
+                // newton-gregory, see eval(). the nodes become the steps -k (or k backwards)
+                // added to s, and each level gets its 1 / (k + 1).
+                uint32_t       n = _diffs.count;
+                std::vector<T> recips(n);
+
+                for (uint32_t k = 0; k < n; k++)
+                {
+                    coeffs[k] = _diffs.raw(k, _fwd ? 0 : n - 1 - k);
+                    nodes[k] = _fwd ? -(T)k : (T)k;
+                    recips[k] = (T)1 / (k + 1);
+                }
+
+                i = gregoryMany(coeffs, nodes, recips, _dp[_fwd ? 0 : n - 1].x, (float)(1 / _diffs.step), _xs, _ys, _n, min, max);
+            }
+            else
+            {
+                for (uint32_t k = 0; k < _diffs.count; k++)
+                {
+                    coeffs[k] = _diffs.coeff(k, _fwd);
+                    nodes[k] = _dp[_fwd ? k : _dp.size() - 1 - k].x;
+                }
 
-                simplifySigns(false, _dp[index].x, &s, &v);
-                snprintf(buff, sizeof(buff), "(%.4g %c %.4g)", _dp[_i].x, s, v);
-                tmp.append(buff);
+                i = hornerMany(coeffs, nodes, _compensated, _xs, _ys, _n, min, max);
             }
         }
 
-        tmp.append("}");
-        _out.append("} \\above{1pt} ");
-        _out.append(tmp);
-        _out.append("}");
+        for (; i < _n; i++)
+        {
+            _ys[i] = (float)(_compensated ? Newton::evalCompensated(_dp, _xs[i], _fwd, _diffs) : Newton::eval(_dp, _xs[i], _fwd, _diffs));
+            minMax(_ys[i], min, max);
+        }
+
+        if (_outMin) *_outMin = min;
+        if (_outMax) *_outMax = max;
     }
 
-    float Newton::eval(std::vector<ImVec2>& _dp, float _x, bool _fwd, std::vector<std::vector<float>>& _diffs)
+    template <typename T>
+    void Newton::calculateMonomials(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, std::vector<T>& _outCoeffs)
     {
-        if (0 == _dp.size()) return 0.0f;
+        _outCoeffs.clear();
+        if (0 == _dp.size()) return;
 
-        float r = _dp[_fwd ? 0 : _dp.size() - 1].y;
-        float prod;
+        // same nested multiplication as in eval(), but carried out on polynomials: 
+        // in each step the accumulated coefficients get multiplied by (x - x_i) and
+        // the next newton coefficient gets added to the constant term.
+        uint32_t last = _diffs.count - 1;
+        T        xi;
 
-        for (uint32_t i = 1; i < _diffs.size(); i++)
+        _outCoeffs.resize(_diffs.count, 0);
+        _outCoeffs[0] = _diffs.coeff(last, _fwd);
+
+        for (int32_t i = last - 1; i >= 0; i--)
         {
-            prod = 1.0f;
-            for (uint32_t j = 0; j <= i - 1; j++)
+            xi = _dp[_fwd ? i : _dp.size() - 1 - i].x;
+
+            for (int32_t k = last - i; k > 0; k--)
             {
-                prod *= (_x - _dp[_fwd ? j : _dp.size() - 1 - j].x);
+                _outCoeffs[k] = _outCoeffs[k - 1] - xi * _outCoeffs[k];
             }
-
-            r += (_diffs[i][_fwd ? 0 : _diffs[i].size() - 1] * prod);
+            _outCoeffs[0] = -xi * _outCoeffs[0] + _diffs.coeff(i, _fwd);
         }
-
-        return r;
     }
 
-    float Newton::eval(std::vector<ImVec2>& _dp, float _x, bool _fwd)
+    template <typename T>
+    T Newton::evalMonomials(std::vector<T>& _coeffs, float _x)
     {
-        std::vector<std::vector<float>> diffs;
-        Newton::calculateDiffs(_dp, diffs);
+        if (0 == _coeffs.size()) return 0;
 
-        return Newton::eval(_dp, _x, _fwd, diffs);
+        T r = _coeffs[_coeffs.size() - 1];
+
+        for (int32_t i = _coeffs.size() - 2; i >= 0; i--)
+        {
+            r = r * _x + _coeffs[i];
+        }
+
+        return r;
     }
 
-    void Newton::latexFormula(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _diffs, bool _fwd, std::string& _out)
+    template <typename T>
+    void Newton::latexFormula(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, std::string& _out)
     {
         static char buff[255];
 
         _out.reserve(2500);
 
-        snprintf(buff, sizeof(buff), "P(x)=f_%" PRIu32, _fwd ? 0 : _dp.size() - 1);
+        snprintf(buff, sizeof(buff), "P(x)=f_%" PRIu32, _fwd ? 0 : (uint32_t)_dp.size() - 1);
         _out = std::string(buff);
 
-        for (uint32_t i = 1; i < _diffs.size(); i++)
+        for (uint32_t i = 1; i < _diffs.count; i++)
         {
             _out.append(" + f[x_0");
             for (uint32_t j = 0; j < i; j++)
@@ -213,13 +1442,14 @@ namespace finter
 
             for (uint32_t j = 0; j <= i - 1; j++)
             {
-                snprintf(buff, sizeof(buff), " (x - x_%" PRIu32 ")", _fwd ? j : _dp.size() - 1 - j);
+                snprintf(buff, sizeof(buff), " (x - x_%" PRIu32 ")", _fwd ? j : (uint32_t)_dp.size() - 1 - j);
                 _out.append(buff);
             }
         }
     }
 
-    void Newton::latexPx(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _diffs, bool _fwd, std::string& _out)
+    template <typename T>
+    void Newton::latexPx(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, std::string& _out)
     {
         static char  buff[255];
         float v;
@@ -230,9 +1460,9 @@ namespace finter
         _out.reserve(2500);
         _out = std::string(buff);
 
-        for (uint32_t i = 1; i < _diffs.size(); i++)
+        for (uint32_t i = 1; i < _diffs.count; i++)
         {
-            simplifySigns(true, _diffs[i][_fwd ? 0 : _diffs[i].size() - 1], &s, &v);
+            simplifySigns(true, (float)_diffs.coeff(i, _fwd), &s, &v);
             snprintf(buff, sizeof(buff), " %c %.4g \\cdot", s, v);
             _out.append(buff);
 
@@ -246,7 +1476,8 @@ namespace finter
         }
     }
 
-    void Newton::latexFx(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _diffs, bool _fwd, uint32_t _from, uint32_t _to, std::string& _out)
+    template <typename T>
+    void Newton::latexFx(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, uint32_t _from, uint32_t _to, std::string& _out)
     {
         static char buff[255];
 
@@ -268,57 +1499,484 @@ namespace finter
         float v1, v2;
         char s1, s2;
 
-        simplifySigns(false, Newton::getY(_dp, _diffs, diffOrderPrev, _from), &s1, &v1);
+        simplifySigns(false, (float)_diffs.at(diffOrderPrev, _from), &s1, &v1);
         simplifySigns(false, _dp[_from].x, &s2, &v2);
 
         snprintf(buff, sizeof(buff), "{{%.4g %c %.4g} \\above{1pt} {%.4g %c %.4g}} = %.4g",
-            Newton::getY(_dp, _diffs, diffOrderPrev, _from + 1), s1, v1,
+            (double)_diffs.at(diffOrderPrev, _from + 1), s1, v1,
             _dp[_to].x, s2, v2,
-            _diffs[diffOrder][_from]);
+            (double)_diffs.at(diffOrder, _from));
         _out.append(buff);
     }
 
-    void Newton::calculateDiffs(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _outDiffs)
+    template <typename T>
+    void Newton::calculateDiffs(std::vector<Vec2>& _dp, DiffTable<T>& _outDiffs, float _step)
     {
+        _outDiffs.step = _step;
+        _outDiffs.scale.clear();
         _outDiffs.resize(_dp.size());
 
-        uint32_t order = 1;
-        uint32_t prevOrderSize = _dp.size();
+        for (uint32_t e = 0; e < _dp.size(); e++)
+        {
+            Newton::calculateDiffsRow(_dp, _outDiffs, e, 0);
+        }
+    }
+
+    // the incremental updates below rely on f[x(i), ..., x(i+order)] only depending on the
+    // points i ... i+order, so an edit at k only touches the entries with i <= k <= i+order,
+    // which all live in the rows from k onwards.
+
+    template <typename T>
+    void Newton::appendDiffs(std::vector<Vec2>& _dp, DiffTable<T>& _diffs)
+    {
+        _diffs.resize(_dp.size());
+
+        Newton::calculateDiffsRow(_dp, _diffs, _dp.size() - 1, 0);
+    }
+
+    template <typename T>
+    void Newton::removeDiffsAt(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, uint32_t _index)
+    {
+        uint32_t n = _dp.size();
+        T*       row;
+
+        // new row e is old row e + 1 without the entries that spanned the removed point. the
+        // ones starting past it are moved down as they are, the others get recomputed. rows
+        // only ever move to lower offsets, so this can be done in place.
+        for (uint32_t e = _index; e < n; e++)
+        {
+            row = _diffs.data.data() + DiffTable<T>::rowOffset(e);
+            memmove(row, row + e + 1, (e - _index + 1) * sizeof(T));
+
+            Newton::calculateDiffsRow(_dp, _diffs, e, e - _index + 1);
+        }
+
+        _diffs.resize(n);
+    }
+
+    template <typename T>
+    void Newton::updateDiffsAt(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, uint32_t _index)
+    {
+        for (uint32_t e = _index; e < _dp.size(); e++)
+        {
+            Newton::calculateDiffsRow(_dp, _diffs, e, e - _index);
+        }
+    }
+
+    template <typename T>
+    void Newton::calculateDiffsRow(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, uint32_t _e, uint32_t _fromOrder)
+    {
+        // f[x(e-o), ..., x(e)] = (f[x(e-o+1), ..., x(e)] - f[x(e-o), ..., x(e-1)]) / (x(e) - x(e-o)),
+        // the two terms being order o-1 of this row and the previous one. finite differences
+        // are the same without the division.
+        T* row = _diffs.data.data() + DiffTable<T>::rowOffset(_e);
+        T* prev = row - _e;
+
+        if (0 == _fromOrder)
+        {
+            row[0] = _dp[_e].y;
+            _fromOrder = 1;
+        }
+
+        if (0 != _diffs.step)
+        {
+            for (uint32_t o = _fromOrder; o <= _e; o++)
+            {
+                row[o] = row[o - 1] - prev[o - 1];
+            }
+        }
+        else
+        {
+            for (uint32_t o = _fromOrder; o <= _e; o++)
+            {
+                row[o] = (row[o - 1] - prev[o - 1]) / ((T)_dp[_e].x - _dp[_e - o].x);
+            }
+        }
+    }
+
+    template <typename T>
+    void Chebyshev::fit(std::vector<Vec2>& _dp, std::vector<T>& _weights, ChebyshevSeries<T>& _outSeries)
+    {
+        uint32_t n = _dp.size();
+        const T  pi = (T)3.14159265358979323846264338327950288L;
+
+        _outSeries.coeffs.clear();
+        if (0 == n) return;
+
+        _outSeries.xMin = _dp[0].x;
+        _outSeries.xMax = _dp[0].x;
+        for (uint32_t i = 1; i < n; i++)
+        {
+            _outSeries.xMin = fmin(_outSeries.xMin, _dp[i].x);
+            _outSeries.xMax = fmax(_outSeries.xMax, _dp[i].x);
+        }
+
+        T mid = ((T)_outSeries.xMin + _outSeries.xMax) / 2;
+        T half = ((T)_outSeries.xMax - _outSeries.xMin) / 2;
+
+        // the interpolating polynomial (barycentric formula, as in Lagrange::eval() but with the
+        // abscissa in T) sampled at the n chebyshev points of the first kind, t_j = cos(pi (j + 1/2) / n).
+        // it has degree n - 1, so these samples determine it exactly.
+        std::vector<T> cosines(4 * n);
+        std::vector<T> values(n);
+
+        for (uint32_t m = 0; m < 4 * n; m++)
+        {
+            cosines[m] = std::cos(pi * m / (2 * n));
+        }
+
+        for (uint32_t j = 0; j < n; j++)
+        {
+            T x = mid + half * cosines[2 * j + 1];
+            T num = 0;
+            T den = 0;
+            T t;
+
+            for (uint32_t i = 0; i < n; i++)
+            {
+                t = x - _dp[i].x;
+                if (t == 0)
+                {
+                    num = _dp[i].y;
+                    den = 1;
+                    break;
+                }
+
+                t = _weights[i] / t;
+                num += t * _dp[i].y;
+                den += t;
+            }
+
+            values[j] = num / den;
+        }
+
+        // DCT-II of the samples: c_k = 2/n sum(f_j cos(pi k (j + 1/2) / n)), c_0 halved. the
+        // angle pi k (2j + 1) / 2n is looked up in the table, reduced modulo a full turn.
+        _outSeries.coeffs.resize(n);
+
+        T cMax = 0;
+        for (uint32_t k = 0; k < n; k++)
+        {
+            T c = 0;
+
+            for (uint32_t j = 0; j < n; j++)
+            {
+                c += values[j] * cosines[(k * (2 * j + 1)) % (4 * n)];
+            }
+
+            _outSeries.coeffs[k] = c * 2 / n;
+            cMax = std::max(cMax, std::abs(_outSeries.coeffs[k]));
+        }
+        _outSeries.coeffs[0] /= 2;
+
+        // the tail below the working precision doesn't change any value, so it is chopped off
+        // which makes the evaluation cheaper for smooth data.
+        T tiny = cMax * std::numeric_limits<T>::epsilon();
+        while (_outSeries.coeffs.size() > 1 && std::abs(_outSeries.coeffs.back()) <= tiny)
+        {
+            _outSeries.coeffs.pop_back();
+        }
+    }
+
+    template <typename T>
+    T Chebyshev::eval(ChebyshevSeries<T>& _series, float _x)
+    {
+        if (0 == _series.coeffs.size()) return 0;
+
+        // clenshaw's recurrence, b_k = c_k + 2t b_(k+1) - b_(k+2), summing up the series with one
+        // multiplication per term and no divisions. it is stable for t in [-1, 1].
+        T t = _series.xMax > _series.xMin ? ((T)_x - ((T)_series.xMin + _series.xMax) / 2) * 2 / ((T)_series.xMax - _series.xMin) : 0;
+        T b1 = 0;
+        T b2 = 0;
+        T tmp;
+
+        for (int32_t k = _series.coeffs.size() - 1; k > 0; k--)
+        {
+            tmp = b1;
+            b1 = 2 * t * b1 - b2 + _series.coeffs[k];
+            b2 = tmp;
+        }
+
+        return t * b1 - b2 + _series.coeffs[0];
+    }
+
+    template <typename T>
+    void Chebyshev::evalMany(ChebyshevSeries<T>& _series, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax)
+    {
+        float  min = FLT_MAX;
+        float  max = -FLT_MAX;
+        size_t i = 0;
+
+        if (_series.coeffs.size() > 0)
+            i = clenshawMany(_series, _xs, _ys, _n, min, max);
 
-        while (prevOrderSize > 1)
+        for (; i < _n; i++)
         {
-            std::vector<float>& d = _outDiffs[order];
+            _ys[i] = (float)Chebyshev::eval(_series, _xs[i]);
+            minMax(_ys[i], min, max);
+        }
+
+        if (_outMin) *_outMin = min;
+        if (_outMax) *_outMax = max;
+    }
 
-            // calculate f[x[i], ..., x(i+n)]
-            d.resize(prevOrderSize - 1);
-            for (uint32_t i = 0; i < prevOrderSize - 1; i++)
+    template <typename T>
+    void Spline::build(std::vector<Vec2>& _dp, SplineBoundary _boundary, float _slopeStart, float _slopeEnd, float _step, CubicSpline<T>& _outSpline)
+    {
+        std::vector<uint32_t> order(_dp.size());
+        std::vector<T>        y;
+
+        // imported data is usually sorted already, which spares the sort.
+        for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+        if (!std::is_sorted(_dp.begin(), _dp.end(), [](const Vec2& _a, const Vec2& _b) { return _a.x < _b.x; }))
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t _a, uint32_t _b) { return _dp[_a].x < _dp[_b].x; });
+
+        // knots sharing an abscissa would make a zero width piece, the later datapoint wins.
+        _outSpline.knots.clear();
+        y.reserve(order.size());
+
+        for (uint32_t i = 0; i < order.size(); i++)
+        {
+            if (_outSpline.knots.size() > 0 && _outSpline.knots.back() == _dp[order[i]].x)
             {
-                d[i] = (Newton::getY(_dp, _outDiffs, order - 1, i + 1) - Newton::getY(_dp, _outDiffs, order - 1, i))
-                    / (_dp[i + order].x - _dp[i].x);
+                y.back() = _dp[order[i]].y;
+                continue;
             }
 
-            prevOrderSize = d.size();
-            order++;
+            _outSpline.knots.push_back(_dp[order[i]].x);
+            y.push_back(_dp[order[i]].y);
+        }
+
+        uint32_t n = y.size();
+        uint32_t m = n > 1 ? n - 1 : n;
+
+        _outSpline.step = n > 2 && n == _dp.size() ? _step : 0.0f;
+        _outSpline.a.assign(y.begin(), y.begin() + m);
+        _outSpline.b.assign(m, 0);
+        _outSpline.c.assign(n, 0);
+        _outSpline.d.assign(m, 0);
+
+        if (n < 2) return;
+
+        // continuity of the first and second derivatives at the inner knots leaves a tridiagonal
+        // system in the c_i (half the curvature), h(i-1) c(i-1) + 2(h(i-1) + h(i)) c(i) + h(i) c(i+1)
+        // = 3 (s(i) - s(i-1)) with s the slopes of the chords. the end rows come from the boundary.
+        // it is diagonally dominant, so the thomas algorithm solves it in O(n) without pivoting.
+        std::vector<T> h(m);
+        std::vector<T> s(m);
+        std::vector<T> diag(n);
+        std::vector<T> rhs(n);
+        std::vector<T>& c = _outSpline.c;
+
+        for (uint32_t i = 0; i < m; i++)
+        {
+            h[i] = (T)_outSpline.knots[i + 1] - _outSpline.knots[i];
+            s[i] = (y[i + 1] - y[i]) / h[i];
+        }
+
+        if (Spline_Clamped == _boundary)
+        {
+            diag[0] = 2 * h[0];
+            rhs[0] = 3 * (s[0] - _slopeStart);
+            diag[n - 1] = 2 * h[m - 1];
+            rhs[n - 1] = 3 * (_slopeEnd - s[m - 1]);
+        }
+        else
+        {
+            diag[0] = 1;
+            rhs[0] = 0;
+            diag[n - 1] = 1;
+            rhs[n - 1] = 0;
+        }
+
+        for (uint32_t i = 1; i < n - 1; i++)
+        {
+            diag[i] = 2 * (h[i - 1] + h[i]);
+            rhs[i] = 3 * (s[i] - s[i - 1]);
+        }
+
+        // forward elimination, the sub and super diagonals being h(i-1) and h(i) (zero next to the
+        // natural end rows).
+        T upper = Spline_Clamped == _boundary ? h[0] : 0;
+
+        for (uint32_t i = 1; i < n; i++)
+        {
+            T lower = i < n - 1 || Spline_Clamped == _boundary ? h[i - 1] : 0;
+            T w = lower / diag[i - 1];
+
+            diag[i] -= w * upper;
+            rhs[i] -= w * rhs[i - 1];
+            upper = i < n - 1 ? h[i] : 0;
+        }
+
+        c[n - 1] = rhs[n - 1] / diag[n - 1];
+
+        for (int32_t i = n - 2; i >= 0; i--)
+        {
+            T u = i > 0 || Spline_Clamped == _boundary ? h[i] : 0;
+            c[i] = (rhs[i] - u * c[i + 1]) / diag[i];
+        }
+
+        for (uint32_t i = 0; i < m; i++)
+        {
+            _outSpline.b[i] = s[i] - h[i] * (2 * c[i] + c[i + 1]) / 3;
+            _outSpline.d[i] = (c[i + 1] - c[i]) / (3 * h[i]);
+        }
+
+        c.resize(m);
+    }
+
+    template <typename T>
+    uint32_t Spline::findPiece(CubicSpline<T>& _spline, float _x, uint32_t _hint)
+    {
+        std::vector<float>& knots = _spline.knots;
+        uint32_t            m = _spline.a.size();
+
+        if (m <= 1) return 0;
+
+        // equidistant knots give the piece right away, give or take the rounding.
+        if (0.0f != _spline.step)
+        {
+            float    f = (_x - knots[0]) / _spline.step;
+            uint32_t i = f > 0.0f ? (f < m - 1 ? (uint32_t)f : m - 1) : 0;
+
+            while (i > 0 && _x < knots[i]) i--;
+            while (i + 1 < m && _x >= knots[i + 1]) i++;
+
+            return i;
+        }
+
+        // batches are usually sorted, so try the piece of the previous abscissa and the next one
+        // before searching.
+        if (_hint < m && (0 == _hint || _x >= knots[_hint]))
+        {
+            if (_hint + 1 == m || _x < knots[_hint + 1]) return _hint;
+            if (_hint + 2 == m || _x < knots[_hint + 2]) return _hint + 1;
         }
 
-        _outDiffs.resize(order);
+        // the number of inner knots at or below x.
+        return std::upper_bound(knots.begin() + 1, knots.begin() + m, _x) - (knots.begin() + 1);
+    }
+
+    template <typename T>
+    T Spline::eval(CubicSpline<T>& _spline, float _x)
+    {
+        if (0 == _spline.a.size()) return 0;
+
+        uint32_t i = findPiece(_spline, _x, 0);
+        T        t = (T)_x - _spline.knots[i];
+
+        return _spline.a[i] + t * (_spline.b[i] + t * (_spline.c[i] + t * _spline.d[i]));
     }
 
-    float Newton::getY(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _diffs, uint32_t _order, uint32_t _index)
+    template <typename T>
+    void Spline::evalMany(CubicSpline<T>& _spline, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax)
     {
-        if (_order < 1)
+        float    min = FLT_MAX;
+        float    max = -FLT_MAX;
+        uint32_t i = 0;
+        T        t;
+
+        if (0 == _spline.a.size())
         {
-            return _dp[_index].y;
+            memset(_ys, 0, _n * sizeof(float));
+            if (_n > 0) min = max = 0.0f;
         }
         else
         {
-            return _diffs[_order][_index];
+            for (size_t k = 0; k < _n; k++)
+            {
+                i = findPiece(_spline, _xs[k], i);
+                t = (T)_xs[k] - _spline.knots[i];
+
+                _ys[k] = (float)(_spline.a[i] + t * (_spline.b[i] + t * (_spline.c[i] + t * _spline.d[i])));
+                minMax(_ys[k], min, max);
+            }
+        }
+
+        if (_outMin) *_outMin = min;
+        if (_outMax) *_outMax = max;
+    }
+
+    void Spline::latexPx(std::string& _out)
+    {
+        _out = "S_{i}(x) = a_{i} + b_{i} (x - x_{i}) + c_{i} (x - x_{i})^{2} + d_{i} (x - x_{i})^{3}, \\quad x_{i} \\le x \\le x_{i+1}";
+    }
+
+    template <typename T>
+    void Spline::latexSx(CubicSpline<T>& _spline, uint32_t _i, std::string& _out)
+    {
+        static char buff[255];
+        float v;
+        float x;
+        char  s;
+        char  sx;
+
+        const T* coeffs[] = { _spline.a.data(), _spline.b.data(), _spline.c.data(), _spline.d.data() };
+
+        snprintf(buff, sizeof(buff), "S_{%" PRIu32 "}(x) = ", _i);
+        _out = std::string(buff);
+
+        simplifySigns(false, _spline.knots[_i], &sx, &x);
+
+        for (uint32_t p = 0; p < 4; p++)
+        {
+            simplifySigns(true, (float)coeffs[p][_i], &s, &v);
+            if (p == 0 && s == '+') s = ' ';
+
+            if (0 == p)
+                snprintf(buff, sizeof(buff), "%c %.4g", s, v);
+            else if (1 == p)
+                snprintf(buff, sizeof(buff), " %c %.4g (x %c %.4g)", s, v, sx, x);
+            else
+                snprintf(buff, sizeof(buff), " %c %.4g (x %c %.4g)^{%" PRIu32 "}", s, v, sx, x, p);
+
+            _out.append(buff);
+        }
+
+        if (_i + 1 < _spline.knots.size())
+        {
+            snprintf(buff, sizeof(buff), ", \\quad %.4g \\le x \\le %.4g", _spline.knots[_i], _spline.knots[_i + 1]);
+            _out.append(buff);
         }
     }
 
-    Interpolator::Interpolator()
+#define INSTANTIATE_PRECISION(T) \
+    template T    Lagrange::eval<T>(std::vector<Vec2>&, float, std::vector<T>&); \
+    template T    Lagrange::evalCompensated<T>(std::vector<Vec2>&, float, std::vector<T>&); \
+    template void Lagrange::evalMany<T>(std::vector<Vec2>&, std::vector<T>&, bool, const float*, float*, size_t, float*, float*); \
+    template T    Lagrange::calculateWeights<T>(std::vector<Vec2>&, std::vector<T>&); \
+    template bool Lagrange::appendWeight<T>(std::vector<Vec2>&, std::vector<T>&, T); \
+    template bool Lagrange::removeWeightAt<T>(std::vector<Vec2>&, std::vector<T>&, uint32_t, float, T); \
+    template bool Lagrange::updateWeightAt<T>(std::vector<Vec2>&, std::vector<T>&, uint32_t, float, T); \
+    template T    Newton::eval<T>(std::vector<Vec2>&, float, bool, DiffTable<T>&); \
+    template T    Newton::evalCompensated<T>(std::vector<Vec2>&, float, bool, DiffTable<T>&); \
+    template void Newton::evalMany<T>(std::vector<Vec2>&, DiffTable<T>&, bool, bool, const float*, float*, size_t, float*, float*); \
+    template void Newton::latexFormula<T>(std::vector<Vec2>&, DiffTable<T>&, bool, std::string&); \
+    template void Newton::latexPx<T>(std::vector<Vec2>&, DiffTable<T>&, bool, std::string&); \
+    template void Newton::latexFx<T>(std::vector<Vec2>&, DiffTable<T>&, bool, uint32_t, uint32_t, std::string&); \
+    template void Newton::calculateDiffs<T>(std::vector<Vec2>&, DiffTable<T>&, float); \
+    template void Newton::appendDiffs<T>(std::vector<Vec2>&, DiffTable<T>&); \
+    template void Newton::removeDiffsAt<T>(std::vector<Vec2>&, DiffTable<T>&, uint32_t); \
+    template void Newton::updateDiffsAt<T>(std::vector<Vec2>&, DiffTable<T>&, uint32_t); \
+    template void Newton::calculateMonomials<T>(std::vector<Vec2>&, DiffTable<T>&, bool, std::vector<T>&); \
+    template T    Newton::evalMonomials<T>(std::vector<T>&, float); \
+    template void Chebyshev::fit<T>(std::vector<Vec2>&, std::vector<T>&, ChebyshevSeries<T>&); \
+    template T    Chebyshev::eval<T>(ChebyshevSeries<T>&, float); \
+    template void Chebyshev::evalMany<T>(ChebyshevSeries<T>&, const float*, float*, size_t, float*, float*); \
+    template void Spline::build<T>(std::vector<Vec2>&, SplineBoundary, float, float, float, CubicSpline<T>&); \
+    template T    Spline::eval<T>(CubicSpline<T>&, float); \
+    template void Spline::evalMany<T>(CubicSpline<T>&, const float*, float*, size_t, float*, float*); \
+    template void Spline::latexSx<T>(CubicSpline<T>&, uint32_t, std::string&);
+
+    INSTANTIATE_PRECISION(float)
+    INSTANTIATE_PRECISION(double)
+    INSTANTIATE_PRECISION(long double)
+
+#undef INSTANTIATE_PRECISION
+
+    Interpolator::Interpolator() : freeSlot(UINT32_MAX)
     {
-        container.reserve(100);
     }
 
     Interpolator::~Interpolator()
@@ -326,20 +1984,109 @@ namespace finter
         container.clear();
     }
 
-    void Interpolator::add(Interpolation& _interpolation)
+    InterpolationHandle Interpolator::add(const Interpolation& _interpolation)
+    {
+        container.push_back(_interpolation);
+        return added(true);
+    }
+
+    InterpolationHandle Interpolator::add(Interpolation&& _interpolation)
+    {
+        container.push_back(std::move(_interpolation));
+        return added(true);
+    }
+
+    InterpolationHandle Interpolator::emplace()
+    {
+        container.emplace_back();
+        return added(false);
+    }
+
+    InterpolationHandle Interpolator::added(bool _recalculate)
     {
-        container.push_back(_interpolation); // <-- this involves a copy
+        Interpolation&      newIntp = container.back();
+        InterpolationHandle handle;
 
-        Interpolation& newIntp = container.back();
-        newIntp.recalculateDiffs();
+        if (_recalculate)
+            newIntp.recalculate();
 
         if (0 == strlen(newIntp.name))
             snprintf(newIntp.name, INTERPOLATION_NAME_LEN, "interpolation at 0x%p", (void*)&newIntp);
+
+        if (UINT32_MAX != freeSlot)
+        {
+            handle.slot = freeSlot;
+            freeSlot = slots[freeSlot].index;
+        }
+        else
+        {
+            handle.slot = (uint32_t)slots.size();
+            slots.push_back({ 0, 0 });
+        }
+
+        slots[handle.slot].index = (uint32_t)container.size() - 1;
+        handle.generation = slots[handle.slot].generation;
+        containerSlots.push_back(handle.slot);
+
+        return handle;
+    }
+
+    void Interpolator::remove(InterpolationHandle _handle)
+    {
+        if (nullptr != get(_handle))
+            removeAt(slots[_handle.slot].index);
     }
 
     void Interpolator::removeAt(uint32_t _index)
     {
-        container.erase(container.begin() + _index);
+        uint32_t last = (uint32_t)container.size() - 1;
+        uint32_t slot = containerSlots[_index];
+
+        // the last interpolation takes the place of the removed one.
+        if (_index != last)
+        {
+            container[_index] = std::move(container[last]);
+            containerSlots[_index] = containerSlots[last];
+            slots[containerSlots[_index]].index = _index;
+        }
+
+        container.pop_back();
+        containerSlots.pop_back();
+
+        slots[slot].generation++;
+        slots[slot].index = freeSlot;
+        freeSlot = slot;
+    }
+
+    void Interpolator::clear()
+    {
+        for (uint32_t i = 0; i < containerSlots.size(); i++)
+        {
+            Slot& s = slots[containerSlots[i]];
+            s.generation++;
+            s.index = freeSlot;
+            freeSlot = containerSlots[i];
+        }
+
+        container.clear();
+        containerSlots.clear();
+    }
+
+    Interpolation* Interpolator::get(InterpolationHandle _handle)
+    {
+        if (_handle.slot >= slots.size() || slots[_handle.slot].generation != _handle.generation)
+            return nullptr;
+
+        return &container[slots[_handle.slot].index];
+    }
+
+    InterpolationHandle Interpolator::getHandle(uint32_t _index)
+    {
+        InterpolationHandle handle;
+        handle.slot = containerSlots[_index];
+        handle.generation = slots[handle.slot].generation;
+
+        return handle;
     }
 
     Interpolation& Interpolator::getAt(uint32_t _index)
@@ -2,7 +2,7 @@
 #define INTERPOLATOR_H_
 
 #include "defines.h"
-#include "imgui.h"
+#include "vec2.h"
 
 #include <string>
 #include <vector>
@@ -16,30 +16,157 @@ namespace finter
         Interpolation_Lagrange,
         Interpolation_NewtonFwd,
         Interpolation_NewtonBwd,
+        Interpolation_Spline,
     };
 
+    enum InterpolationPrecision
+    {
+        Precision_Float,
+        Precision_Double,
+        Precision_LongDouble,
+    };
+
+    enum SplineBoundary
+    {
+        Spline_Natural,                                            // no curvature at the end points.
+        Spline_Clamped,                                            // given slopes at the end points.
+    };
+
+    // the weights, differences and coefficients below are templated on the type T they are
+    // computed and evaluated in (float, double or long double). datapoints and abscissas
+    // stay single precision, the differences between them are taken in T.
+
     struct Lagrange
     {
-        static float eval(std::vector<ImVec2>& _dp, float _x);
-        static void  latexFormula(std::vector<ImVec2>& _dp, std::string& _out);
-        static void  latexPx(std::vector<ImVec2>& _dp, std::string& _out);
-        static void  latexLx(std::vector<ImVec2>& _dp, uint32_t _i, std::string& _out);
+        template <typename T> static T    eval(std::vector<Vec2>& _dp, float _x, std::vector<T>& _weights);
+        static float                      eval(std::vector<Vec2>& _dp, float _x);
+        template <typename T> static T    evalCompensated(std::vector<Vec2>& _dp, float _x, std::vector<T>& _weights);
+        template <typename T> static void evalMany(std::vector<Vec2>& _dp, std::vector<T>& _weights, bool _compensated, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax);
+        static void                       latexFormula(std::vector<Vec2>& _dp, std::string& _out);
+        static void                       latexPx(std::vector<Vec2>& _dp, std::string& _out);
+        static void                       latexLx(std::vector<Vec2>& _dp, uint32_t _i, std::string& _out);
+        template <typename T> static T    calculateWeights(std::vector<Vec2>& _dp, std::vector<T>& _outWeights);
+        template <typename T> static bool appendWeight(std::vector<Vec2>& _dp, std::vector<T>& _weights, T _scale);
+        template <typename T> static bool removeWeightAt(std::vector<Vec2>& _dp, std::vector<T>& _weights, uint32_t _index, float _removedX, T _scale);
+        template <typename T> static bool updateWeightAt(std::vector<Vec2>& _dp, std::vector<T>& _weights, uint32_t _index, float _prevX, T _scale);
+    };
 
-    private:
-        static float lx(std::vector<ImVec2>& _dp, uint32_t _i, float _x);
+    // divided differences f[x(i), ..., x(i+order)] of n datapoints, packed into a single triangular
+    // buffer. entries are grouped in rows by the last point they span (e = i + order), so row e holds
+    // orders 0 ... e and appending a point only appends a row. order 0 holds the y values themselves.
+    // for equidistant nodes (step != 0) the buffer holds the finite differences instead, which need
+    // no divisions. at() and the others still return divided ones, f[...] = delta^o / (o! step^o).
+    template <typename T>
+    struct DiffTable
+    {
+        std::vector<T>                  data;
+        std::vector<T>                  scale;                     // 1 / (o! step^o) per order, only with finite differences.
+        uint32_t                        count;                     // number of datapoints (rows) in the table.
+        T                               step;                      // spacing of the nodes if equidistant, 0 otherwise.
+
+        DiffTable() : count(0), step(0) {}
+
+        inline static uint32_t          rowOffset(uint32_t _e) { return _e * (_e + 1) / 2; }
+        inline T                        raw(uint32_t _order, uint32_t _index) { return data[rowOffset(_index + _order) + _order]; }
+        inline T                        at(uint32_t _order, uint32_t _index) { return 0 != step ? raw(_order, _index) * scale[_order] : raw(_order, _index); }
+        inline T                        fwd(uint32_t _order) { return at(_order, 0); }                           // f[x0, ..., x(order)]
+        inline T                        bwd(uint32_t _order) { return at(_order, count - 1 - _order); }          // f[x(n-1-order), ..., x(n-1)]
+        inline T                        coeff(uint32_t _order, bool _fwd) { return _fwd ? fwd(_order) : bwd(_order); }
+
+        // resizes the table to _count datapoints, keeping the rows that remain.
+        inline void                     resize(uint32_t _count)
+        {
+            count = _count;
+            data.resize(rowOffset(_count));
+
+            if (0 != step)
+            {
+                uint32_t o = scale.size();
+                scale.resize(_count);
+
+                for (; o < _count; o++) scale[o] = 0 == o ? 1 : scale[o - 1] / (o * step);
+            }
+        }
     };
 
     struct Newton
     {
-        static float eval(std::vector<ImVec2>& _dp, float _x, bool _fwd, std::vector<std::vector<float>>& _diffs);
-        static float eval(std::vector<ImVec2>& _dp, float _x, bool _fwd);
-        static void  latexFormula(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _diffs, bool _fwd, std::string& _out);
-        static void  latexPx(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _diffs, bool _fwd, std::string& _out);
-        static void  latexFx(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _diffs, bool _fwd, uint32_t _from, uint32_t _to, std::string& _out);
-        static void  calculateDiffs(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _outDiffs);
+        template <typename T> static T    eval(std::vector<Vec2>& _dp, float _x, bool _fwd, DiffTable<T>& _diffs);
+        static float                      eval(std::vector<Vec2>& _dp, float _x, bool _fwd);
+        template <typename T> static T    evalCompensated(std::vector<Vec2>& _dp, float _x, bool _fwd, DiffTable<T>& _diffs);
+        template <typename T> static void evalMany(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, bool _compensated, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax);
+        template <typename T> static void latexFormula(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, std::string& _out);
+        template <typename T> static void latexPx(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, std::string& _out);
+        template <typename T> static void latexFx(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, uint32_t _from, uint32_t _to, std::string& _out);
+        template <typename T> static void calculateDiffs(std::vector<Vec2>& _dp, DiffTable<T>& _outDiffs, float _step = 0.0f);
+        template <typename T> static void appendDiffs(std::vector<Vec2>& _dp, DiffTable<T>& _diffs);
+        template <typename T> static void removeDiffsAt(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, uint32_t _index);
+        template <typename T> static void updateDiffsAt(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, uint32_t _index);
+        template <typename T> static void calculateMonomials(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, bool _fwd, std::vector<T>& _outCoeffs);
+        template <typename T> static T    evalMonomials(std::vector<T>& _coeffs, float _x);
 
     private:
-        inline static float getY(std::vector<ImVec2>& _dp, std::vector<std::vector<float>>& _diffs, uint32_t _order, uint32_t _index);
+        template <typename T> inline static void calculateDiffsRow(std::vector<Vec2>& _dp, DiffTable<T>& _diffs, uint32_t _e, uint32_t _fromOrder);
+    };
+
+    // chebyshev expansion sum(c_k * T_k(t)) of a polynomial over [xMin, xMax], t being x mapped to [-1, 1].
+    template <typename T>
+    struct ChebyshevSeries
+    {
+        std::vector<T>                  coeffs;
+        float                           xMin;
+        float                           xMax;
+
+        ChebyshevSeries() : xMin(-1.0f), xMax(1.0f) {}
+    };
+
+    struct Chebyshev
+    {
+        template <typename T> static void fit(std::vector<Vec2>& _dp, std::vector<T>& _weights, ChebyshevSeries<T>& _outSeries);
+        template <typename T> static T    eval(ChebyshevSeries<T>& _series, float _x);
+        template <typename T> static void evalMany(ChebyshevSeries<T>& _series, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax);
+    };
+
+    // piecewise cubic through the datapoints sorted by x, piece i being a_i + b_i t + c_i t^2 + d_i t^3
+    // with t = x - x(i) over [x(i), x(i+1)]. the coefficients are kept one array per power, and the
+    // end pieces are extended past the first/last knot.
+    template <typename T>
+    struct CubicSpline
+    {
+        std::vector<float>              knots;                     // x(i), ascending, one more than there are pieces.
+        std::vector<T>                  a;
+        std::vector<T>                  b;
+        std::vector<T>                  c;
+        std::vector<T>                  d;
+        float                           step;                      // spacing of the knots if equidistant (direct piece lookup), 0 otherwise.
+
+        CubicSpline() : step(0.0f) {}
+    };
+
+    struct Spline
+    {
+        template <typename T> static void build(std::vector<Vec2>& _dp, SplineBoundary _boundary, float _slopeStart, float _slopeEnd, float _step, CubicSpline<T>& _outSpline);
+        template <typename T> static T    eval(CubicSpline<T>& _spline, float _x);
+        template <typename T> static void evalMany(CubicSpline<T>& _spline, const float* _xs, float* _ys, size_t _n, float* _outMin, float* _outMax);
+        static void                       latexPx(std::string& _out);
+        template <typename T> static void latexSx(CubicSpline<T>& _spline, uint32_t _i, std::string& _out);
+
+    private:
+        template <typename T> inline static uint32_t findPiece(CubicSpline<T>& _spline, float _x, uint32_t _hint);
+    };
+
+    // everything an interpolation derives from its datapoints, in one precision.
+    template <typename T>
+    struct InterpolationState
+    {
+        InterpolationState() : weightsScale(1) {}
+
+        DiffTable<T>                    diffs;
+        std::vector<T>                  weights;
+        T                               weightsScale;              // factor the node differences were scaled by when computing the weights.
+        std::vector<T>                  monomials;                 // power basis coefficients (a0 + a1*x + ...), only kept up to date when enabled.
+        ChebyshevSeries<T>              chebyshev;                 // the same polynomial in the chebyshev basis, only kept up to date when enabled.
+        CubicSpline<T>                  spline;
     };
 
     struct Interpolation
@@ -47,35 +174,134 @@ namespace finter
         Interpolation();
         ~Interpolation();
 
+        // the destructor would otherwise suppress the moves, and every container growth would deep copy.
+        Interpolation(const Interpolation&) = default;
+        Interpolation(Interpolation&&) = default;
+        Interpolation&                  operator=(const Interpolation&) = default;
+        Interpolation&                  operator=(Interpolation&&) = default;
+
         char                            name[INTERPOLATION_NAME_LEN];
-        std::vector<ImVec2>             datapoints;
-        ImVec2*                         datapointSelected;
+        std::vector<Vec2>               datapoints;
+        uint32_t                        datapointSelected;         // index of the selected datapoint, INTERPOLATION_NO_DATAPOINT if none. the datapoint edits keep it on the same point.
         bool                            datapointsEquidistant;
-        std::vector<std::vector<float>> diffs;
+        float                           datapointsSpacing;         // x(i+1) - x(i) if equidistant (and at least 2 points), 0 otherwise.
+        InterpolationPrecision          precision;                 // precision the state is computed and evaluated in, only that one is kept up to date.
+        InterpolationState<float>       stateF;
+        InterpolationState<double>      stateD;
+        InterpolationState<long double> stateLD;
+        bool                            monomialsEnabled;
+        bool                            compensated;               // evaluate with compensated (error-free) arithmetic, about twice the precision.
+        bool                            chebyshevEnabled;          // evaluate every polynomial variant from the chebyshev expansion instead.
+        SplineBoundary                  splineBoundary;
+        float                           splineSlopeStart;          // end slopes of the clamped spline.
+        float                           splineSlopeEnd;
+        uint64_t                        revision;                  // unique id of the current state, changes whenever the datapoints do.
+
+        // appends the "x0,y0; x1,y1; ..." pairs of _inBuff to _outData (newlines separate pairs too).
+        // on a syntax error nothing is appended and _outErrorPos gets the offset it was found at.
+        static bool                     parseData(const char* _inBuff, std::vector<Vec2>& _outData, size_t* _outErrorPos = nullptr);
+        static bool                     parseData(const char* _inBuff, size_t _len, std::vector<Vec2>& _outData, size_t* _outErrorPos = nullptr);
+
+        // calls _fn with the state of the current precision.
+        template <typename Fn>
+        inline void                     withState(Fn _fn)
+        {
+            switch (precision)
+            {
+            case Precision_Double:      _fn(stateD); break;
+            case Precision_LongDouble:  _fn(stateLD); break;
+            default:                    _fn(stateF); break;
+            }
+        }
+
+        float                           eval(InterpolationVariant _variant, float _x);
+        inline float                    evalLagrange(float _x) { return eval(Interpolation_Lagrange, _x); }
+        inline float                    evalNewtonFwd(float _x) { return eval(Interpolation_NewtonFwd, _x); }
+        inline float                    evalNewtonBwd(float _x) { return eval(Interpolation_NewtonBwd, _x); }
+        inline float                    evalSpline(float _x) { return eval(Interpolation_Spline, _x); }
+        float                           evalMonomials(float _x);
 
-        static bool                     parseData(const char* _inBuff, std::vector<ImVec2>& _outData);
+        // the polynomials are only computed up to MAX_POLYNOMIAL_DATAPOINTS datapoints, their tables grow
+        // quadratically and such degrees are of no use anyway. past that they evaluate to NaN, only the
+        // spline is there.
+        inline bool                     hasPolynomial() { return datapoints.size() <= MAX_POLYNOMIAL_DATAPOINTS; }
 
-        inline float                    evalLagrange(float _x) { return Lagrange::eval(datapoints, _x); }
-        inline float                    evalNewtonFwd(float _x) { return Newton::eval(datapoints, _x, true, diffs); }
-        inline float                    evalNewtonBwd(float _x) { return Newton::eval(datapoints, _x, false, diffs); }
+        // evaluates _n abscissas at once (vectorized when the cpu allows it), optionally reporting the min/max of the results.
+        void                            evalMany(InterpolationVariant _variant, const float* _xs, float* _ys, size_t _n, float* _outMin = nullptr, float* _outMax = nullptr);
 
-        void                            recalculateDiffs();        
+        void                            recalculate();
+        void                            recalculateDiffs();
+        void                            recalculateWeights();
+        void                            recalculateMonomials();
+        void                            recalculateChebyshev();
+        void                            recalculateSpline();
+        void                            setPrecision(InterpolationPrecision _precision);
+        void                            setCompensated(bool _compensated);
+        void                            setChebyshev(bool _enabled);
+        void                            setSplineBoundary(SplineBoundary _boundary, float _slopeStart = 0.0f, float _slopeEnd = 0.0f);
+
+        // datapoint edits. these keep the cached diffs and weights up to date incrementally.
+        void                            addDatapoint(const Vec2& _p);
+        void                            setDatapointAt(uint32_t _index, const Vec2& _p);
+        void                            removeDatapointAt(uint32_t _index);
+        void                            clearDatapoints();
+
+    private:
+        bool                            updateSpacing();
+    };
+
+    // refers to an interpolation of an Interpolator for as long as it isn't removed, wherever it
+    // gets moved to in the meantime. a default constructed handle refers to none.
+    struct InterpolationHandle
+    {
+        InterpolationHandle() : slot(UINT32_MAX), generation(0) {}
+
+        inline bool                     operator==(const InterpolationHandle& _other) const { return slot == _other.slot && generation == _other.generation; }
+        inline bool                     operator!=(const InterpolationHandle& _other) const { return !(*this == _other); }
+
+        uint32_t                        slot;
+        uint32_t                        generation;
     };
 
+    // keeps the interpolations contiguous for iteration (indices are only stable until the next
+    // removal, which moves the last interpolation into the gap). handles go through a slot table,
+    // so looking them up and removing them are constant time.
     class Interpolator
     {
     public:
                                         Interpolator();
                                         ~Interpolator();
 
-        void                            add(Interpolation& _interpolation);
+        InterpolationHandle             add(const Interpolation& _interpolation);
+        InterpolationHandle             add(Interpolation&& _interpolation);
+
+        // constructs an empty interpolation in place, to be filled and recalculated by the caller
+        // (e.g. restored from a session, whose state is already up to date).
+        InterpolationHandle             emplace();
+        void                            remove(InterpolationHandle _handle);
         void                            removeAt(uint32_t _index);
+        void                            clear();
+
+        // nullptr once the interpolation was removed. the pointer itself is only good until the next add or removal.
+        Interpolation*                  get(InterpolationHandle _handle);
+        InterpolationHandle             getHandle(uint32_t _index);
         Interpolation&                  getAt(uint32_t _index);
         Interpolation*                  getInterpolations();
         uint32_t                        getCount();
 
     private:
+        struct Slot
+        {
+            uint32_t                    index;                     // in container, or the next free slot while unused.
+            uint32_t                    generation;                // bumped on removal, so the handles given out for it stop matching.
+        };
+
+        InterpolationHandle             added(bool _recalculate);
+
         std::vector<Interpolation>      container;
+        std::vector<uint32_t>           containerSlots;            // slot of each interpolation, parallel to container.
+        std::vector<Slot>               slots;
+        uint32_t                        freeSlot;                  // head of the unused slots list, UINT32_MAX if empty.
     };
 }
 
@@ -0,0 +1,129 @@
+#include "latexqueue.h"
+#include "formulacache.h"
+#include "defines.h"
+#include "latex.hpp"
+
+#include <memory>
+
+namespace finter
+{
+    LatexQueue::LatexQueue()
+    {
+        frame = 0;
+        quit = false;
+
+        thread = std::thread(&LatexQueue::workerMain, this);
+    }
+
+    LatexQueue::~LatexQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        cv.notify_all();
+
+        thread.join();
+    }
+
+    void LatexQueue::request(const std::string& _latex)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto it = requested.find(_latex);
+            if (it != requested.end())
+            {
+                it->second = frame;
+                return;
+            }
+
+            requested.insert(std::pair<std::string, uint64_t>(_latex, frame));
+            pending.push_back(_latex);
+        }
+        cv.notify_one();
+    }
+
+    bool LatexQueue::poll(LatexBitmap& _out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (done.empty()) return false;
+
+        _out = std::move(done.front());
+        done.pop_front();
+
+        // only forget about it once handed over, so it can't be queued twice meanwhile
+        requested.erase(_out.latex);
+
+        return true;
+    }
+
+    void LatexQueue::endFrame()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        frame++;
+    }
+
+    void LatexQueue::workerMain()
+    {
+        // v8 isolates and wkhtmltoimage are bound to the thread that created them,
+        // so the context lives (and dies) here. it's only brought up on the first
+        // formula missing from the disk cache, warm launches never need it.
+        std::unique_ptr<Latex> latex;
+        FormulaCache           cache(Latex::exe_folder_path(), FORMULA_CACHE_MAX_BYTES);
+        LatexBitmap            bmp;
+        uint64_t               key;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return quit || !pending.empty(); });
+
+                if (quit) return;
+
+                bmp.latex = std::move(pending.front());
+                pending.pop_front();
+
+                // nobody asked for it lately, it's not on the screen anymore
+                if (frame - requested[bmp.latex] > LATEX_REQUEST_TTL)
+                {
+                    requested.erase(bmp.latex);
+                    continue;
+                }
+            }
+
+            bmp.pixels.clear();
+            bmp.w = 0;
+            bmp.h = 0;
+
+            key = FormulaCache::key(bmp.latex, LATEX_STYLESHEET, "");
+
+            if (!cache.load(key, bmp.pixels, bmp.w, bmp.h))
+            {
+                try
+                {
+                    if (!latex) latex.reset(new Latex(LATEX_STYLESHEET));
+
+                    int w, h;
+                    latex->to_bitmap(bmp.latex, bmp.pixels, w, h);
+
+                    bmp.w = w;
+                    bmp.h = h;
+                    cache.store(key, bmp.pixels, bmp.w, bmp.h);
+                }
+                catch (const std::exception&)
+                {
+                    // an empty bitmap tells the ui this formula can't be rendered
+                    bmp.pixels.clear();
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.push_back(std::move(bmp));
+            }
+        }
+    }
+}
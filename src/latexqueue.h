@@ -0,0 +1,57 @@
+#ifndef LATEXQUEUE_H_
+#define LATEXQUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace finter
+{
+    struct LatexBitmap
+    {
+        std::string                     latex;
+        std::vector<uint8_t>            pixels;                     // RGBA8, w * h * 4 bytes. empty if rendering failed.
+        int32_t                         w;
+        int32_t                         h;
+    };
+
+    // renders latex formulas into bitmaps on a background thread. the thread owns its
+    // own latex context (v8 + wkhtmltoimage), so nothing of it ever runs on the ui thread.
+    class LatexQueue
+    {
+    public:
+                                        LatexQueue();
+                                        ~LatexQueue();
+
+        // asks for a formula to be rendered. requesting a formula which is already queued
+        // just marks it as still wanted in the current frame.
+        void                            request(const std::string& _latex);
+
+        // pops a finished bitmap, if any.
+        bool                            poll(LatexBitmap& _out);
+
+        // to be called once per frame. queued formulas which weren't requested for
+        // LATEX_REQUEST_TTL frames are no longer visible and get dropped.
+        void                            endFrame();
+
+    private:
+        std::thread                     thread;
+        std::mutex                      mutex;
+        std::condition_variable         cv;
+
+        std::deque<std::string>         pending;                    // formulas waiting to be rendered, in request order.
+        std::map<std::string, uint64_t> requested;                  // queued/in-flight formula -> last frame it was requested in.
+        std::deque<LatexBitmap>         done;                       // finished bitmaps waiting to be picked up.
+        uint64_t                        frame;
+        bool                            quit;
+
+        void                            workerMain();
+    };
+}
+
+#endif // LATEXQUEUE_H_
@@ -0,0 +1,136 @@
+#include "mappedfile.h"
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace finter
+{
+    bool fileSeek(FILE* _f, uint64_t _offset, int _origin)
+    {
+#if defined(_WIN32)
+        return 0 == _fseeki64(_f, (int64_t)_offset, _origin);
+#else
+        return 0 == fseeko(_f, (off_t)_offset, _origin);
+#endif
+    }
+
+    uint64_t fileTell(FILE* _f)
+    {
+#if defined(_WIN32)
+        int64_t pos = _ftelli64(_f);
+#else
+        int64_t pos = ftello(_f);
+#endif
+        return pos < 0 ? 0 : (uint64_t)pos;
+    }
+
+    MappedFile::MappedFile()
+    {
+        data = nullptr;
+        size = 0;
+#if defined(_WIN32)
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#else
+        fd = -1;
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(const char* _path)
+    {
+        close();
+
+#if defined(_WIN32)
+        file = CreateFileA(_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (INVALID_HANDLE_VALUE == file) return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize))
+        {
+            close();
+            return false;
+        }
+
+        // an empty file can't be mapped, but it's still a valid (empty) file
+        if (0 == fileSize.QuadPart)
+        {
+            close();
+            return true;
+        }
+
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (NULL == mapping)
+        {
+            close();
+            return false;
+        }
+
+        data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (nullptr == data)
+        {
+            close();
+            return false;
+        }
+
+        size = (size_t)fileSize.QuadPart;
+#else
+        fd = ::open(_path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (0 != fstat(fd, &st))
+        {
+            close();
+            return false;
+        }
+
+        if (0 == st.st_size)
+        {
+            close();
+            return true;
+        }
+
+        void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == p)
+        {
+            close();
+            return false;
+        }
+
+        data = (const uint8_t*)p;
+        size = (size_t)st.st_size;
+#endif
+
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+#if defined(_WIN32)
+        if (nullptr != data) UnmapViewOfFile(data);
+        if (NULL != mapping) CloseHandle(mapping);
+        if (INVALID_HANDLE_VALUE != file) CloseHandle(file);
+
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (nullptr != data) munmap((void*)data, size);
+        if (fd >= 0) ::close(fd);
+
+        fd = -1;
+#endif
+        data = nullptr;
+        size = 0;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace finter
+{
+    // stdio seek and tell with 64 bit offsets, long is 32 bits on windows.
+    bool                                fileSeek(FILE* _f, uint64_t _offset, int _origin = SEEK_SET);
+    uint64_t                            fileTell(FILE* _f);
+
+    // read-only memory mapping of a whole file.
+    class MappedFile
+    {
+    public:
+                                        MappedFile();
+                                        ~MappedFile();
+
+        bool                            open(const char* _path);
+        void                            close();
+
+        inline const uint8_t*           getData() { return data; }
+        inline size_t                   getSize() { return size; }
+
+    private:
+                                        MappedFile(const MappedFile&) = delete;
+        MappedFile&                     operator=(const MappedFile&) = delete;
+
+        const uint8_t*                  data;
+        size_t                          size;
+
+#if defined(_WIN32)
+        void*                           file;
+        void*                           mapping;
+#else
+        int                             fd;
+#endif
+    };
+}
+
+#endif // MAPPEDFILE_H_
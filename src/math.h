@@ -1,18 +1,29 @@
 #ifndef MATH_H_
 #define MATH_H_
 
+#include <charconv>
 #include <cmath>
+#include <limits>
+#include <type_traits>
+#include <stdint.h>
+
+// fma is a single instruction on these targets (e.g. -march=haswell, /arch:AVX2).
+#if defined(__FMA__) || defined(__AVX2__) || defined(__ARM_FEATURE_FMA)
+#   define FINTER_FAST_FMA 1
+#else
+#   define FINTER_FAST_FMA 0
+#endif
 
 namespace finter
 {
     inline float ffloor(float _f)
     {
-        return std::floorf(_f);
+        return std::floor(_f);
     }
 
     inline float fceil(float _f)
     {
-        return std::ceilf(_f);
+        return std::ceil(_f);
     }
 
     inline float fround(float _f)
@@ -67,5 +78,76 @@ namespace finter
             *_outSign = '-';
         }
     }
+
+    // number syntax shared by the datapoint parsers (pasted text and imported files): blanks
+    // around the numbers are skipped, the separators are up to each of them.
+    inline bool isBlank(char _c)
+    {
+        return ' ' == _c || '\t' == _c || '\r' == _c;
+    }
+
+    inline const char* skipBlanks(const char* _p, const char* _end)
+    {
+        while (_p < _end && isBlank(*_p)) _p++;
+        return _p;
+    }
+
+    // from_chars neither takes a leading '+' nor depends on the locale. returns where the number
+    // ended, or nullptr if there was none or it isn't finite.
+    inline const char* parseFloat(const char* _p, const char* _end, float& _out)
+    {
+        if (_p + 1 < _end && '+' == *_p && '-' != _p[1]) _p++;
+
+        std::from_chars_result r = std::from_chars(_p, _end, _out);
+
+        return std::errc() == r.ec && std::isfinite(_out) ? r.ptr : nullptr;
+    }
+
+    // error-free transformations: _a + _b == _outS + _outE and _a * _b == _outP + _outE exactly,
+    // barring overflow. the product error comes from fma where it is a single instruction, and
+    // otherwise from splitting the operands in halves (dekker). the split (and twoSum) must not be
+    // contracted into fmas by the compiler, the build turns that off for the files using them.
+    template <typename T>
+    inline void twoSum(T _a, T _b, T& _outS, T& _outE)
+    {
+        T s = _a + _b;
+        T z = s - _a;
+
+        _outE = (_a - (s - z)) + (_b - z);
+        _outS = s;
+    }
+
+    template <typename T>
+    inline void split(T _a, T& _outHi, T& _outLo)
+    {
+        static const T splitter = (T)((1ULL << ((std::numeric_limits<T>::digits + 1) / 2)) + 1);
+        T c = splitter * _a;
+
+        _outHi = c - (c - _a);
+        _outLo = _a - _outHi;
+    }
+
+    template <typename T>
+    inline void twoProd(T _a, T _b, T& _outP, T& _outE)
+    {
+        T p = _a * _b;
+
+        // long double has no hardware fma, it would be emulated.
+        if constexpr (FINTER_FAST_FMA && !std::is_same<T, long double>::value)
+        {
+            _outE = std::fma(_a, _b, -p);
+        }
+        else
+        {
+            T ah, al, bh, bl;
+
+            split(_a, ah, al);
+            split(_b, bh, bl);
+
+            _outE = al * bl - (((p - ah * bh) - al * bh) - ah * bl);
+        }
+
+        _outP = p;
+    }
 }
 #endif // MATH_H_
\ No newline at end of file
@@ -2,13 +2,13 @@
 #include "interpolator.h"
 #include "imgui.h"
 #include "imgui_internal.h"
+#include "imgui_stdlib.h"
 #include "math.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include <inttypes.h>
 #include <algorithm>
+#include <chrono>
+#include <utility>
 
 namespace finter
 {
@@ -31,28 +31,45 @@ namespace finter
         goptLagrange = { true, ImVec4(1.0f, 1.0f, 0.0f, 1.0f) };
         goptNewtonFwd = { true , ImVec4(0.0f, 1.0f, 1.0f, 1.0f) };
         goptNewtonBwd = { true, ImVec4(0.0f, 1.0f, 0.0f, 1.0f) };
+        goptSpline = { true, ImVec4(1.0f, 0.5f, 0.0f, 1.0f) };
         goptAxes = { true, ImVec4(1.0f, 1.0f, 1.0f, 1.0f) };
         goptDatapoints = { true, ImVec4(1.0f, 0.0f, 1.0f, 1.0f) };
         goptCurPoint = { true, ImVec4(1.0f, 1.0f, 1.0f, 1.0f) };
 
+        graphSize = ImVec2(MIDDLE_PANEL_WIDTH, GRAPH_HEIGHT);
+        curveBuilder = new ImDrawList(ImGui::GetDrawListSharedData());
         rangeMin = { -100, -100 };
         rangeMax = { 100, 100 };
+        curIntp = nullptr;
         curVariant = Interpolation_Lagrange;
+        refreshPending = Refresh_None;
+        importOpened = false;
+        importFormat = Import_Auto;
+        sessionOpened = false;
+        tabPending = false;
 
         latexLagrange.steps.reserve(MAX_DATAPOINTS);
         latexNewtonFwd.steps.reserve(MAX_DATAPOINTS);
         latexNewtonBwd.steps.reserve(MAX_DATAPOINTS);
+        latexSpline.steps.reserve(MAX_DATAPOINTS);
     }
 
     Renderer::~Renderer()
     {
+        delete curveBuilder;
     }
 
     void Renderer::Draw()
     {
+        curIntp = interpolator.get(curHandle);
+        refreshLatexTextures();
+
         drawPanelLeft();
         drawPanelMiddle();
         drawPanelBottom();
+
+        flushRefresh();
+        latexQueue.endFrame();
     }
 
     void Renderer::drawPanelLeft()
@@ -76,14 +93,41 @@ namespace finter
 
         if (ImGui::Button("New Interpolation", ImVec2(ImGui::GetContentRegionAvailWidth(), 0)))
         {
-            newIntp = new Interpolation();
+            newIntp = Interpolation();
             newIntpOpened = true;
-            ZERO_MEM(newIntpBuff);
+            newIntpBuff.clear();
+            newIntpError.clear();
 
             ImGui::OpenPopup("New Interpolation");
         }
         drawPopupNewInterpolation();
 
+        if (ImGui::Button("Import Datapoints", ImVec2(ImGui::GetContentRegionAvailWidth(), 0)))
+        {
+            importOpened = true;
+            ImGui::OpenPopup("Import Datapoints");
+        }
+        drawPopupImport();
+        pollImport();
+
+        if (importer.isRunning())
+            ImGui::ProgressBar(importer.getProgress(), ImVec2(ImGui::GetContentRegionAvailWidth(), 0), "Importing...");
+        else if (!importStatus.empty())
+            ImGui::TextWrapped("%s", importStatus.c_str());
+
+        if (ImGui::Button("Session", ImVec2(ImGui::GetContentRegionAvailWidth(), 0)))
+        {
+            sessionOpened = true;
+            ImGui::OpenPopup("Session");
+        }
+        drawPopupSession();
+
+        if (!sessionStatus.empty())
+            ImGui::TextWrapped("%s", sessionStatus.c_str());
+
+        // the popups above may have added interpolations, which can move them around.
+        curIntp = interpolator.get(curHandle);
+
         if (ImGui::ListBoxHeader("Interpolations"))
         {
             for (uint32_t i = 0; i < interpolator.getCount(); i++)
@@ -94,10 +138,9 @@ namespace finter
                 selected = (curIntp == &interpolation);
                 if (ImGui::Selectable(interpolation.name, &selected))
                 {
+                    curHandle = interpolator.getHandle(i);
                     curIntp = &interpolation;
-                    Renderer::refreshGraphValues();
-                    Renderer::refreshLatexFormulas(curVariant, false);
-                    Renderer::resetView();
+                    Renderer::invalidate(Refresh_Curves | Refresh_ViewY | Refresh_Latex);
                 }
                 ImGui::PopID();
             }
@@ -109,36 +152,74 @@ namespace finter
         if (nullptr != curIntp)
         {
             ImGui::InputText("Name", curIntp->name, sizeof(curIntp->name));
-            drawListboxDataPoints(curIntp->datapoints, &curIntp->datapointSelected);
+            drawListboxDataPoints(*curIntp);
             ImGui::LabelText("Equidistant", curIntp->datapointsEquidistant ? "Yes" : "No");
 
+            int32_t precision = curIntp->precision;
+            if (ImGui::Combo("Precision", &precision, "Float\0Double\0Long Double\0"))
+            {
+                curIntp->setPrecision((InterpolationPrecision)precision);
+                Renderer::invalidate(Refresh_Curves | Refresh_ViewY | Refresh_Latex);
+            }
+            ImGui::SameLine();
+            Renderer::helpMarker("Precision the polynomials are computed and evaluated in. Higher degrees may need more than float.");
+
+            bool compensated = curIntp->compensated;
+            if (ImGui::Checkbox("Compensated", &compensated))
+            {
+                curIntp->setCompensated(compensated);
+                Renderer::invalidate(Refresh_Curves | Refresh_ViewY);
+            }
+            ImGui::SameLine();
+            Renderer::helpMarker("Evaluates with compensated arithmetic, recovering the rounding errors of every step. Slower, but about twice as accurate.");
+
+            bool chebyshev = curIntp->chebyshevEnabled;
+            if (ImGui::Checkbox("Chebyshev", &chebyshev))
+            {
+                curIntp->setChebyshev(chebyshev);
+                Renderer::invalidate(Refresh_Curves | Refresh_ViewY);
+            }
+            ImGui::SameLine();
+            Renderer::helpMarker(curIntp->datapointsEquidistant
+                ? "Evaluates the polynomial from its Chebyshev expansion (Clenshaw). Faster and stable at high degrees, recommended for equidistant data like this."
+                : "Evaluates the polynomial from its Chebyshev expansion (Clenshaw). Faster and stable at high degrees.");
+
             ImGui::Separator();
 
             if (ImGui::BeginTabBar("Polynomials", ImGuiTabBarFlags_None))
             {
-                if (Renderer::drawTab("Lagrange", latexLagrange))
+                if (Renderer::drawTab("Lagrange", Interpolation_Lagrange, latexLagrange))
                 {
                     tabChanged = true;
                     curVariant = Interpolation_Lagrange;
                     curPoint.y = curIntp->evalLagrange(curPoint.x);
                 }
 
-                if (Renderer::drawTab("Newton Forward", latexNewtonFwd))
+                if (Renderer::drawTab("Newton Forward", Interpolation_NewtonFwd, latexNewtonFwd))
                 {
                     tabChanged = true;
                     curVariant = Interpolation_NewtonFwd;
                     curPoint.y = curIntp->evalNewtonFwd(curPoint.x);
                 }
                 
-                if (Renderer::drawTab("Newton Backward", latexNewtonBwd))
+                if (Renderer::drawTab("Newton Backward", Interpolation_NewtonBwd, latexNewtonBwd))
                 {
                     tabChanged = true;
                     curVariant = Interpolation_NewtonBwd;
                     curPoint.y = curIntp->evalNewtonBwd(curPoint.x);
                 }
 
+                if (Renderer::drawTab("Cubic Spline", Interpolation_Spline, latexSpline))
+                {
+                    tabChanged = true;
+                    curVariant = Interpolation_Spline;
+                    curPoint.y = curIntp->evalSpline(curPoint.x);
+                }
+
                 if (tabChanged)
-                    Renderer::refreshLatexFormulas(curVariant, false);
+                    Renderer::invalidate(Refresh_Latex);
+
+                tabPending = false;
 
 
                 ImGui::EndTabBar();
@@ -181,54 +262,60 @@ namespace finter
         ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
         ImGui::BeginChild("graph-child-container", ImVec2(0, GRAPH_HEIGHT), false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
 
-        float w = ImGui::GetContentRegionAvailWidth();
+        graphSize = ImVec2(ImGui::GetContentRegionAvailWidth(), GRAPH_HEIGHT);
 
         ImDrawList* dl = ImGui::GetWindowDrawList();        
 
         if (goptAxes.visible)
             drawGraphAxes(dl, goptAxes.color);
 
+        Renderer::drawGraphCurves(dl);
+
         if (goptLagrange.visible)
-        {
-            Renderer::drawGraphCurve(gdataLagrange.yS, rangeMin.y, rangeMax.y, goptLagrange.color, ImVec2(w, GRAPH_HEIGHT));
             Renderer::drawGraphPoint(dl, mousePointLagrange, false, goptLagrange.color);
-        }
-   
+
         if (goptNewtonFwd.visible)
-        {
-            Renderer::drawGraphCurve(gdataNewtonFwd.yS, rangeMin.y, rangeMax.y, goptNewtonFwd.color, ImVec2(w, GRAPH_HEIGHT));
             Renderer::drawGraphPoint(dl, mousePointNewtonFwd, false, goptNewtonFwd.color);
-        }
 
         if (goptNewtonBwd.visible)
-        {
-            Renderer::drawGraphCurve(gdataNewtonBwd.yS, rangeMin.y, rangeMax.y, goptNewtonBwd.color, ImVec2(w, GRAPH_HEIGHT));
             Renderer::drawGraphPoint(dl, mousePointNewtonBwd, false, goptNewtonBwd.color);
-        }
+
+        if (goptSpline.visible)
+            Renderer::drawGraphPoint(dl, mousePointSpline, false, goptSpline.color);
 
         if (goptDatapoints.visible)
         {
-            for (auto it = curIntp->datapoints.begin(); it != curIntp->datapoints.end(); ++it)
+            // large datasets are thinned out, they would cover the graph anyway.
+            std::vector<ImVec2>& data = curIntp->datapoints;
+            size_t               stride = data.size() / GRAPH_MAX_DATAPOINTS + 1;
+
+            for (size_t i = 0; i < data.size(); i += stride)
             {
-                drawGraphPoint(dl, *it, curIntp->datapointSelected == &(*it), goptDatapoints.color);
+                drawGraphPoint(dl, data[i], curIntp->datapointSelected == i, goptDatapoints.color);
             }
+
+            if (stride > 1 && INTERPOLATION_NO_DATAPOINT != curIntp->datapointSelected)
+                drawGraphPoint(dl, data[curIntp->datapointSelected], true, goptDatapoints.color);
         }
         if (goptCurPoint.visible) drawGraphPoint(dl, curPoint, false, goptCurPoint.color, true, 6.0f);
 
-        if (ImGui::IsItemHovered())
+        if (ImGui::IsWindowHovered())
         {
             mousePointLagrange.x = screenToPlaneSpaceX(ImGui::GetMousePos().x - graphPos.x);
             mousePointNewtonFwd.x = mousePointLagrange.x;
             mousePointNewtonBwd.x = mousePointLagrange.x;
+            mousePointSpline.x = mousePointLagrange.x;
 
             mousePointLagrange.y = curIntp->evalLagrange(mousePointLagrange.x);
             mousePointNewtonFwd.y = curIntp->evalNewtonFwd(mousePointLagrange.x);
             mousePointNewtonBwd.y = curIntp->evalNewtonBwd(mousePointLagrange.x);
+            mousePointSpline.y = curIntp->evalSpline(mousePointLagrange.x);
                 
-            ImGui::SetTooltip(" L(%.4f) = %.4f\nNf(%.4f) = %.4f\nNb(%.4f) = %.4f",
+            ImGui::SetTooltip(" L(%.4f) = %.4f\nNf(%.4f) = %.4f\nNb(%.4f) = %.4f\n S(%.4f) = %.4f",
                 mousePointLagrange.x, mousePointLagrange.y,
                 mousePointNewtonFwd.x, mousePointNewtonFwd.y,
-                mousePointNewtonBwd.x, mousePointNewtonBwd.y);
+                mousePointNewtonBwd.x, mousePointNewtonBwd.y,
+                mousePointSpline.x, mousePointSpline.y);
         }
         ImGui::EndChild();
         ImGui::PopItemWidth();
@@ -259,17 +346,18 @@ namespace finter
         ImGui::BeginGroup();
         if (ImGui::Button("Reset View"))
         {
-            Renderer::resetView();
+            Renderer::invalidate(Refresh_ViewY);
         }
 
         if (ImGui::DragFloatRange2("range for x", &rangeMin.x, &rangeMax.x))
         {
-            Renderer::refreshGraphValues();
-            Renderer::resetView();
+            Renderer::invalidate(Refresh_Curves | Refresh_ViewY);
         }
+
+        // the base samples don't depend on the y range, only how much they need refining does
         if (ImGui::DragFloatRange2("range for y", &rangeMin.y, &rangeMax.y))
         {
-            Renderer::refreshGraphValues();
+            Renderer::invalidate(Refresh_Detail);
         }
         
         ImGui::EndGroup();
@@ -282,6 +370,7 @@ namespace finter
         drawOption("Lagrange", goptLagrange);
         drawOption("Newton Fwd", goptNewtonFwd);
         drawOption("Newton Bwd", goptNewtonBwd);
+        drawOption("Spline", goptSpline);
         ImGui::Separator();
         drawOption("Axes", goptAxes);
         drawOption("Datapoints", goptDatapoints);
@@ -291,16 +380,47 @@ namespace finter
         ImGui::End();
     }
 
-    bool Renderer::drawTab(const char* _name, LatexData& _latex)
+    bool Renderer::drawTab(const char* _name, InterpolationVariant _variant, LatexData& _latex)
     {
         bool active = false;
 
-        if (ImGui::BeginTabItem(_name))
+        ImGuiTabItemFlags tflags = tabPending && curVariant == _variant ? ImGuiTabItemFlags_SetSelected : ImGuiTabItemFlags_None;
+
+        if (ImGui::BeginTabItem(_name, nullptr, tflags))
         {
             ImGui::SetWindowFontScale(1.0f);
 
             int32_t degree = i32max(0, curIntp->datapoints.size() - 1);
-            ImGui::Text("Polynomial of Degree %" PRId32, degree);
+
+            if (Interpolation_Spline == _variant)
+            {
+                ImGui::Text("Cubic Spline of %" PRId32 " Pieces", degree);
+
+                int32_t boundary = curIntp->splineBoundary;
+                float   slopes[] = { curIntp->splineSlopeStart, curIntp->splineSlopeEnd };
+                bool    changed = ImGui::Combo("Boundary", &boundary, "Natural\0Clamped\0");
+
+                ImGui::SameLine();
+                Renderer::helpMarker("Natural: no curvature at the first and last datapoints.\nClamped: the curve leaves them with the given slopes.");
+
+                if (Spline_Clamped == boundary)
+                    changed |= ImGui::DragFloat2("End Slopes", slopes, 0.05f);
+
+                if (changed)
+                {
+                    curIntp->setSplineBoundary((SplineBoundary)boundary, slopes[0], slopes[1]);
+                    curPoint.y = curIntp->evalSpline(curPoint.x);
+                    Renderer::invalidate(Refresh_Curves | Refresh_Latex);
+                }
+            }
+            else if (!curIntp->hasPolynomial())
+            {
+                ImGui::TextWrapped("Polynomial of Degree %" PRId32 " (not computed past %d datapoints)", degree, MAX_POLYNOMIAL_DATAPOINTS);
+            }
+            else
+            {
+                ImGui::Text("Polynomial of Degree %" PRId32, degree);
+            }
 
             Renderer::drawLatex(_latex.px.c_str());
 
@@ -315,7 +435,7 @@ namespace finter
             ImGui::Separator();
 
             ImGui::Text("Evaluate");
-            active = ImGui::SliderFloat("Input", &curPoint.x, rangeMin.x, rangeMax.x, "P(%.4f)");
+            active = ImGui::SliderFloat("Input", &curPoint.x, rangeMin.x, rangeMax.x, Interpolation_Spline == _variant ? "S(%.4f)" : "P(%.4f)");
             ImGui::DragFloat("Output", &curPoint.y, 0.0f, 0.0f, 0.0f, "%.4f", 0.0f);
             ImGui::Separator();
 
@@ -338,9 +458,12 @@ namespace finter
 
         if (ImGui::BeginPopupModal("New Interpolation", &newIntpOpened, wflags))
         {
-            ImGui::InputText("Name", newIntp->name, sizeof(newIntp->name));
-            Renderer::helpMarker("Syntax: Semicolon-separated list of points.\n\ne.g. x0,f(x0);x1,f(x1);x2,f(x2)");
-            ImGui::InputTextMultiline("Data", newIntpBuff, INPUT_BUFFER_LEN);
+            ImGui::InputText("Name", newIntp.name, sizeof(newIntp.name));
+            Renderer::helpMarker("Syntax: Semicolon or newline separated list of points.\n\ne.g. x0,f(x0);x1,f(x1);x2,f(x2)");
+            ImGui::InputTextMultiline("Data", &newIntpBuff);
+
+            if (!newIntpError.empty())
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", newIntpError.c_str());
             
             if (ImGui::Button("Cancel", ImVec2(248, 0)))
             {
@@ -351,21 +474,194 @@ namespace finter
 
             if (ImGui::Button("Ok", ImVec2(248, 0)))
             {
-                if (!Interpolation::parseData(newIntpBuff, newIntp->datapoints))
+                size_t errorPos = 0;
+
+                if (!Interpolation::parseData(newIntpBuff.data(), newIntpBuff.size(), newIntp.datapoints, &errorPos))
                 {
-                    // TODO show error to the user
+                    const char* text = newIntpBuff.data();
+                    const char* lineStart = text;
+                    uint32_t    line = 1;
+
+                    for (const char* p = text; p < text + errorPos; p++)
+                    {
+                        if ('\n' == *p)
+                        {
+                            line++;
+                            lineStart = p + 1;
+                        }
+                    }
+
+                    char buff[128];
+                    snprintf(buff, sizeof(buff), "Invalid datapoint at line %" PRIu32 ", column %" PRIu32 ".", line, (uint32_t)(text + errorPos - lineStart) + 1);
+                    newIntpError = buff;
                 }
                 else
                 {
                     newIntpOpened = false;
-                    interpolator.add(*newIntp);
+                    interpolator.add(std::move(newIntp));
                 }
             }
 
             if (!newIntpOpened)
             {
                 ImGui::CloseCurrentPopup();
-                delete newIntp;
+            }
+
+            ImGui::EndPopup();
+        }
+    }
+
+    void Renderer::drawPopupImport()
+    {
+        ImGuiWindowFlags wflags = ImGuiWindowFlags_None
+            | ImGuiWindowFlags_NoMove
+            | ImGuiWindowFlags_NoCollapse
+            | ImGuiWindowFlags_NoSavedSettings
+            | ImGuiWindowFlags_AlwaysUseWindowPadding;
+
+        ImGui::SetNextWindowSize(ImVec2(500, 0));
+
+        if (ImGui::BeginPopupModal("Import Datapoints", &importOpened, wflags))
+        {
+            ImGui::InputText("File", &importPath);
+            ImGui::Combo("Format", &importFormat, "Auto\0CSV / TSV\0Float32 Pairs\0Float64 Pairs\0");
+            ImGui::SameLine();
+            Renderer::helpMarker("CSV / TSV: x and y in the first two columns, one point per line.\n"
+                "Float32 / Float64 Pairs: raw little-endian x, y values.\n\n"
+                "Auto picks binary for .f32, .bin and .f64 files, text otherwise.");
+
+            // the import keeps running in the background if the popup gets closed.
+            if (importer.isRunning()) Renderer::pushDisabled();
+
+            if (ImGui::Button("Cancel", ImVec2(248, 0)))
+            {
+                importOpened = false;
+            }
+
+            ImGui::SameLine(0, 4);
+
+            if (ImGui::Button("Import", ImVec2(248, 0)) && importer.start(importPath.c_str(), (ImportFormat)importFormat))
+            {
+                importOpened = false;
+            }
+
+            if (importer.isRunning()) Renderer::popDisabled();
+
+            if (!importOpened)
+            {
+                ImGui::CloseCurrentPopup();
+            }
+
+            ImGui::EndPopup();
+        }
+    }
+
+    void Renderer::pollImport()
+    {
+        ImportResult result;
+        char         buff[512];
+
+        if (!importer.poll(result)) return;
+
+        if (!result.error.empty())
+        {
+            snprintf(buff, sizeof(buff), "Could not import %s: %s.", result.path.c_str(), result.error.c_str());
+            importStatus = buff;
+            return;
+        }
+
+        size_t      count = result.datapoints.size();
+        const char* name = result.path.c_str();
+
+        // named after the file, without its directory
+        for (const char* p = name; *p; p++)
+        {
+            if ('/' == *p || '\\' == *p) name = p + 1;
+        }
+
+        Interpolation intp;
+        snprintf(intp.name, INTERPOLATION_NAME_LEN, "%s", name);
+        intp.datapoints.swap(result.datapoints);
+        interpolator.add(std::move(intp));
+
+        snprintf(buff, sizeof(buff), "Imported %zu datapoints in %.2f s.", count, result.seconds);
+        importStatus = buff;
+    }
+
+    void Renderer::drawPopupSession()
+    {
+        ImGuiWindowFlags wflags = ImGuiWindowFlags_None
+            | ImGuiWindowFlags_NoMove
+            | ImGuiWindowFlags_NoCollapse
+            | ImGuiWindowFlags_NoSavedSettings
+            | ImGuiWindowFlags_AlwaysUseWindowPadding;
+
+        ImGui::SetNextWindowSize(ImVec2(500, 0));
+
+        if (ImGui::BeginPopupModal("Session", &sessionOpened, wflags))
+        {
+            char        buff[512];
+            std::string error;
+            SessionView view;
+
+            ImGui::InputText("File", &sessionPath);
+            ImGui::SameLine();
+            Renderer::helpMarker("Saves every interpolation along with its computed state, and the graph view.\n"
+                "Opening a session replaces the current interpolations.");
+
+            if (ImGui::Button("Save", ImVec2(248, 0)))
+            {
+                const Interpolation* intps = interpolator.getInterpolations();
+
+                view.rangeMin = Vec2(rangeMin.x, rangeMin.y);
+                view.rangeMax = Vec2(rangeMax.x, rangeMax.y);
+                view.selected = nullptr == curIntp ? UINT32_MAX : (uint32_t)(curIntp - intps);
+                view.variant = curVariant;
+
+                if (Session::save(sessionPath.c_str(), interpolator, view))
+                    snprintf(buff, sizeof(buff), "Saved %" PRIu32 " interpolations to %s.", interpolator.getCount(), sessionPath.c_str());
+                else
+                    snprintf(buff, sizeof(buff), "Could not save %s.", sessionPath.c_str());
+
+                sessionStatus = buff;
+                sessionOpened = false;
+            }
+
+            ImGui::SameLine(0, 4);
+
+            if (ImGui::Button("Open", ImVec2(248, 0)))
+            {
+                auto start = std::chrono::high_resolution_clock::now();
+
+                if (Session::load(sessionPath.c_str(), interpolator, view, error, threadPool))
+                {
+                    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+                    curHandle = view.selected < interpolator.getCount() ? interpolator.getHandle(view.selected) : InterpolationHandle();
+                    rangeMin = ImVec2(view.rangeMin.x, view.rangeMin.y);
+                    rangeMax = ImVec2(view.rangeMax.x, view.rangeMax.y);
+
+                    if (view.variant >= Interpolation_Lagrange && view.variant <= Interpolation_Spline)
+                    {
+                        curVariant = (InterpolationVariant)view.variant;
+                        tabPending = true;
+                    }
+
+                    snprintf(buff, sizeof(buff), "Opened %" PRIu32 " interpolations in %.2f s.", interpolator.getCount(), seconds);
+                    Renderer::invalidate(Refresh_Curves | Refresh_Latex);
+                }
+                else
+                {
+                    snprintf(buff, sizeof(buff), "Could not open %s: %s.", sessionPath.c_str(), error.c_str());
+                }
+
+                sessionStatus = buff;
+                sessionOpened = false;
+            }
+
+            if (!sessionOpened)
+            {
+                ImGui::CloseCurrentPopup();
             }
 
             ImGui::EndPopup();
@@ -406,70 +702,84 @@ namespace finter
         }
     }
 
-    void Renderer::drawListboxDataPoints(std::vector<ImVec2>& _data, ImVec2** _pointSelected)
+    void Renderer::drawListboxDataPoints(Interpolation& _intp)
     {
+        std::vector<ImVec2>& data = _intp.datapoints;
         bool isSelected = false;     // true if a given list item is currently selected
-        bool isModified = false;     // true if our dataset was modified and a recalculation is needed
+        bool isModified = false;     // true if our dataset was modified and the views need a refresh
+        int32_t selected = INTERPOLATION_NO_DATAPOINT == _intp.datapointSelected ? -1 : (int32_t)_intp.datapointSelected;
+        ImVec2 p;
 
         if (ImGui::Button("Clear"))
         {
             isModified = true;
-            _data.clear();
+            selected = -1;
+            _intp.clearDatapoints();
         }
         ImGui::SameLine();
-        if (ImGui::Button("Remove"))
+        if (ImGui::Button("Remove") && selected >= 0)
         {
             isModified = true;
-            _data.erase(
-                std::remove_if(_data.begin(), _data.end(), [_pointSelected](ImVec2& _v) { return &_v == (*_pointSelected); }),
-                _data.end()
-            );
+            _intp.removeDatapointAt(selected);
+            selected = -1;
         }
         ImGui::SameLine();
         if (ImGui::Button("Add"))
         {
             isModified = true;
-            _data.emplace_back(0.0f, 0.0f);
+            _intp.addDatapoint(ImVec2(0.0f, 0.0f));
         }
         ImGui::SameLine();
         if (ImGui::Button("Add Rnd"))
         {
             isModified = true;
             static uint32_t rgX = (uint32_t)(fabs(rangeMax.x - rangeMin.x));
-            _data.emplace_back(rangeMin.x + rand() % rgX, rangeMin.x + rand() % rgX);
+            _intp.addDatapoint(ImVec2(rangeMin.x + rand() % rgX, rangeMin.x + rand() % rgX));
         }
 
         if (ImGui::ListBoxHeader("Datapoints"))
         {
-            for (auto it = _data.begin(); it != _data.end(); ++it)
-            {
-                isSelected = &(*it) == (*_pointSelected);
-                isModified = drawListitemPoint(*it, &isSelected) || isModified;
+            // only the rows in view are submitted, imported datasets can have millions of them
+            ImGuiListClipper clipper((int32_t)data.size());
 
-                if (isSelected)
+            while (clipper.Step())
+            {
+                for (uint32_t i = clipper.DisplayStart; i < (uint32_t)clipper.DisplayEnd; i++)
                 {
-                    (*_pointSelected) = &(*it);
+                    // edit a copy, so the interpolation gets to update its cached values for this point only
+                    p = data[i];
+                    isSelected = (int32_t)i == selected;
+
+                    if (drawListitemPoint(i, p, &isSelected))
+                    {
+                        isModified = true;
+                        _intp.setDatapointAt(i, p);
+                    }
+
+                    if (isSelected)
+                    {
+                        selected = i;
+                    }
                 }
             }
             ImGui::ListBoxFooter();
         }
 
+        _intp.datapointSelected = selected >= 0 ? (uint32_t)selected : INTERPOLATION_NO_DATAPOINT;
+
         if (isModified)
         {
-            curIntp->recalculateDiffs();
-            curPoint.y = Lagrange::eval(curIntp->datapoints, curPoint.x);
-            Renderer::refreshGraphValues();
-            Renderer::refreshLatexFormulas(curVariant, false);
-            Renderer::resetView();
+            curPoint.y = curIntp->evalLagrange(curPoint.x);
+            Renderer::invalidate(Refresh_Curves | Refresh_ViewY | Refresh_Latex);
         }
     }
 
-    bool Renderer::drawListitemPoint(ImVec2& _p, bool* _isSelected)
+    bool Renderer::drawListitemPoint(uint32_t _id, ImVec2& _p, bool* _isSelected)
     {
         static char buff[255];
         bool modified = false;
 
-        ImGui::PushID(&_p);
+        ImGui::PushID(_id);
 
         snprintf(buff, sizeof(buff), "(%.4f, %.4f)", _p.x, _p.y);
         *_isSelected = ImGui::Selectable(buff, _isSelected);
@@ -490,20 +800,107 @@ namespace finter
         return modified;
     }
 
-    void Renderer::drawGraphCurve(std::vector<float>& _yValues, float _yMin, float _yMax, const ImVec4& _color, const ImVec2& _size)
+    void Renderer::drawGraphCurves(ImDrawList* _dl)
     {
-        if (_yValues.size() > 0)
+        GraphData*   gdatas[] = { &gdataLagrange, &gdataNewtonFwd, &gdataNewtonBwd, &gdataSpline };
+        GraphOption* gopts[] = { &goptLagrange, &goptNewtonFwd, &goptNewtonBwd, &goptSpline };
+        CurveMesh*   meshes[] = { &meshLagrange, &meshNewtonFwd, &meshNewtonBwd, &meshSpline };
+
+        // the meshes are rebuilt only when what they were built from changed. otherwise drawing
+        // them is just copying their vertices over, all into the same draw command.
+        for (uint32_t c = 0; c < GRAPH_CURVES; c++)
         {
-            ImGui::SetCursorScreenPos(graphPos);
-            ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.0f, 0.0f, 0.0f, 0.0f));
-            ImGui::PushStyleColor(ImGuiCol_PlotLines, _color);
-            ImGui::PlotLines("##polynomial-curve", &_yValues[0], _yValues.size(), 0, NULL, _yMin, _yMax, _size);
-            ImGui::PopStyleColor(2);
+            CurveMesh& m = *meshes[c];
 
-            graphSize = ImGui::GetItemRectSize();
+            if (!gopts[c]->visible) continue;
+
+            if (m.version != gdatas[c]->version || m.color != ImGui::ColorConvertFloat4ToU32(gopts[c]->color)
+                || m.pos.x != graphPos.x || m.pos.y != graphPos.y || m.size.x != graphSize.x || m.size.y != graphSize.y
+                || m.rangeMin.x != rangeMin.x || m.rangeMin.y != rangeMin.y || m.rangeMax.x != rangeMax.x || m.rangeMax.y != rangeMax.y)
+            {
+                Renderer::buildCurveMesh(*gdatas[c], gopts[c]->color, m);
+            }
+
+            if (0 == m.idx.Size) continue;
+
+            _dl->PrimReserve(m.idx.Size, m.vtx.Size);
+
+            ImDrawIdx base = (ImDrawIdx)_dl->_VtxCurrentIdx;
+            for (int32_t i = 0; i < m.idx.Size; i++)
+            {
+                _dl->_IdxWritePtr[i] = base + m.idx[i];
+            }
+
+            memcpy(_dl->_VtxWritePtr, m.vtx.Data, m.vtx.Size * sizeof(ImDrawVert));
+            _dl->_IdxWritePtr += m.idx.Size;
+            _dl->_VtxWritePtr += m.vtx.Size;
+            _dl->_VtxCurrentIdx += m.vtx.Size;
         }
     }
 
+    void Renderer::buildCurveMesh(GraphData& _data, const ImVec4& _color, CurveMesh& _mesh)
+    {
+        ImDrawList* dl = curveBuilder;
+
+        // tessellate with imgui's own polyline code, then keep the result. the builder never
+        // splits in several draw commands, so the indices of the mesh all start from zero.
+        dl->Clear();
+        dl->Flags &= ~ImDrawListFlags_AllowVtxOffset;
+        dl->PushClipRectFullScreen();
+        dl->PushTextureID(ImGui::GetIO().Fonts->TexID);
+
+        // points far off the graph are pulled in to a few graph heights away, which keeps the
+        // line math well behaved. they're only ever the ends of vertical spans, so nothing bends.
+        float yLimit = GRAPH_OFFSCREEN_LIMIT * graphSize.y;
+        float x, yFirst, yLast, yMin, yMax;
+
+        curvePoints.clear();
+
+        for (uint32_t c = 0; c <= _data.columns.size(); c++)
+        {
+            // the polyline gets broken wherever the curve is undefined
+            if (c == _data.columns.size() || std::isnan(_data.columns[c].first))
+            {
+                if (curvePoints.size() > 1)
+                    dl->AddPolyline(curvePoints.data(), curvePoints.size(), ImColor(_color), false, 1.0f);
+
+                curvePoints.clear();
+                continue;
+            }
+
+            GraphColumn& col = _data.columns[c];
+
+            x = graphPos.x + planeToScreenSpaceX(_data.columnsX + (c + 0.5f) * _data.columnsDx);
+            yFirst = graphPos.y + fclamp(planeToScreenSpaceY(col.first), -yLimit, graphSize.y + yLimit);
+            yLast = graphPos.y + fclamp(planeToScreenSpaceY(col.last), -yLimit, graphSize.y + yLimit);
+            yMin = graphPos.y + fclamp(planeToScreenSpaceY(col.min), -yLimit, graphSize.y + yLimit);
+            yMax = graphPos.y + fclamp(planeToScreenSpaceY(col.max), -yLimit, graphSize.y + yLimit);
+
+            // where the curve moves less than a pixel within the column one point will do,
+            // otherwise the whole range it sweeps is drawn as a vertical span.
+            if (fabs(yMax - yMin) <= 1.0f)
+            {
+                curvePoints.push_back(ImVec2(x, 0.5f * (yMin + yMax)));
+            }
+            else
+            {
+                curvePoints.push_back(ImVec2(x, yFirst));
+                curvePoints.push_back(ImVec2(x, yMin));
+                curvePoints.push_back(ImVec2(x, yMax));
+                curvePoints.push_back(ImVec2(x, yLast));
+            }
+        }
+
+        _mesh.vtx.swap(dl->VtxBuffer);
+        _mesh.idx.swap(dl->IdxBuffer);
+        _mesh.version = _data.version;
+        _mesh.color = ImGui::ColorConvertFloat4ToU32(_color);
+        _mesh.pos = graphPos;
+        _mesh.size = graphSize;
+        _mesh.rangeMin = rangeMin;
+        _mesh.rangeMax = rangeMax;
+    }
+
     void Renderer::drawGraphAxes(ImDrawList* _dl, const ImVec4& _color)
     {
         static ImVec2 p1;
@@ -568,38 +965,29 @@ namespace finter
         auto tex = texMap.find(std::string(_latex));
         if (tex == texMap.end())
         {
-            TextureData* texd = new TextureData();
-
-            latex.to_png(_latex, Latex::tmp_png_path());
-            if (Renderer::loadTextureFromFile(Latex::tmp_png_path().c_str(), &texd->srv, &texd->w, &texd->h))
-            {
-                texd->latex = std::string(_latex);
-                texMap.insert(std::pair<std::string, TextureData*>(std::string(_latex), texd));
+            // not rendered yet. ask the background queue for it and hold its place meanwhile
+            latexQueue.request(std::string(_latex));
+
+            ImGui::PushID(_latex);
+            ImGui::PushStyleColor(ImGuiCol_ChildBg, ImVec4(1.0f, 1.0f, 1.0f, 1.0f));
+            ImGui::BeginChild("latex-formula-container", ImVec2(ImGui::GetContentRegionAvailWidth(), LATEX_PLACEHOLDER_HEIGHT), false);
+            ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "Rendering...");
+            ImGui::EndChild();
+            ImGui::PopStyleColor();
+            ImGui::PopID();
+            return;
+        }
 
-                if (texLru.size() >= TEXTURES_CACHE_SIZE)
-                {
-                    for (int32_t i = 0; i < texLru.size() - TEXTURES_CACHE_SIZE + 1; i++)
-                    {
-                        auto it = std::prev(texLru.end());
-                        texMap.erase((*it)->latex);
-                        (*it)->srv->Release();
-                        
-                        delete *it;
-                        texLru.erase(it);                        
-                    }
-                }
-                texLru.push_front(texd);
-                texd->lruIt = texLru.begin();
-                tex = texMap.find(std::string(_latex));
-            }
+        // cache hit. bring it to the front
+        if (texLru.begin() != tex->second->lruIt)
+        {
+            texLru.splice(texLru.begin(), texLru, tex->second->lruIt, std::next(tex->second->lruIt));
         }
-        else
+
+        if (nullptr == tex->second->srv)
         {
-            // cache hit. bring it to the front
-            if (texLru.begin() != tex->second->lruIt)
-            {
-                texLru.splice(texLru.begin(), texLru, tex->second->lruIt, std::next(tex->second->lruIt));
-            }
+            ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Formula could not be rendered.");
+            return;
         }
 
         ImGui::PushID(tex->second->srv);
@@ -610,21 +998,51 @@ namespace finter
         ImGui::PopStyleColor();
         ImGui::PopID();
     }
-    
-    bool Renderer::loadTextureFromFile(const char* filename, ID3D11ShaderResourceView** out_srv, int* out_width, int* out_height)
+
+    void Renderer::refreshLatexTextures()
     {
-        // Load from disk into a raw RGBA buffer
-        int image_width = 0;
-        int image_height = 0;
-        unsigned char* image_data = stbi_load(filename, &image_width, &image_height, NULL, 4);
-        if (image_data == NULL)
-            return false;
+        LatexBitmap bmp;
+
+        while (latexQueue.poll(bmp))
+        {
+            if (texMap.find(bmp.latex) != texMap.end()) continue;
+
+            TextureData* texd = new TextureData();
+            texd->latex = bmp.latex;
+            texd->srv = nullptr;
+            texd->w = bmp.w;
+            texd->h = bmp.h;
+
+            // an empty bitmap is still cached, so a broken formula isn't queued over and over again
+            if (!bmp.pixels.empty())
+                Renderer::createTexture(bmp.pixels.data(), bmp.w, bmp.h, &texd->srv);
 
+            if (texLru.size() >= TEXTURES_CACHE_SIZE)
+            {
+                for (int32_t i = 0; i < texLru.size() - TEXTURES_CACHE_SIZE + 1; i++)
+                {
+                    auto it = std::prev(texLru.end());
+                    texMap.erase((*it)->latex);
+                    if ((*it)->srv) (*it)->srv->Release();
+
+                    delete *it;
+                    texLru.erase(it);
+                }
+            }
+
+            texMap.insert(std::pair<std::string, TextureData*>(texd->latex, texd));
+            texLru.push_front(texd);
+            texd->lruIt = texLru.begin();
+        }
+    }
+    
+    bool Renderer::createTexture(const unsigned char* _pixels, int32_t _w, int32_t _h, ID3D11ShaderResourceView** _outSrv)
+    {
         // Create texture
         D3D11_TEXTURE2D_DESC desc;
         ZeroMemory(&desc, sizeof(desc));
-        desc.Width = image_width;
-        desc.Height = image_height;
+        desc.Width = _w;
+        desc.Height = _h;
         desc.MipLevels = 1;
         desc.ArraySize = 1;
         desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -635,10 +1053,11 @@ namespace finter
 
         ID3D11Texture2D *pTexture = NULL;
         D3D11_SUBRESOURCE_DATA subResource;
-        subResource.pSysMem = image_data;
+        subResource.pSysMem = _pixels;
         subResource.SysMemPitch = desc.Width * 4;
         subResource.SysMemSlicePitch = 0;
-        device->CreateTexture2D(&desc, &subResource, &pTexture);
+        if (FAILED(device->CreateTexture2D(&desc, &subResource, &pTexture)))
+            return false;
 
         // Create texture view
         D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
@@ -647,13 +1066,9 @@ namespace finter
         srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
         srvDesc.Texture2D.MipLevels = desc.MipLevels;
         srvDesc.Texture2D.MostDetailedMip = 0;
-        device->CreateShaderResourceView(pTexture, &srvDesc, out_srv);
+        device->CreateShaderResourceView(pTexture, &srvDesc, _outSrv);
         pTexture->Release();
 
-        *out_width = image_width;
-        *out_height = image_height;
-        stbi_image_free(image_data);
-
         return true;
     }
 
@@ -682,70 +1097,67 @@ namespace finter
         }
     }
 
-    void Renderer::resetView()
+    void Renderer::flushRefresh()
     {
-        rangeMin.y = fmin(fmin(gdataLagrange.min, gdataNewtonFwd.min), gdataNewtonBwd.min);
-        rangeMax.y = fmax(fmax(gdataLagrange.max, gdataNewtonFwd.max), gdataNewtonBwd.max);
-        refreshGraphValues();
-    }
-
-    void Renderer::refreshGraphValues(uint32_t _steps)
-    {
-        if (NULL == curIntp) return;
+        // edits during the frame only flag what they invalidated, so however many of them
+        // there were, each of these runs at most once, and in the order they depend on.
+        if (nullptr != curIntp)
+        {
+            if (refreshPending & Refresh_Curves)
+            {
+                refreshGraphValues();
+            }
 
-        float increment = (rangeMax.x - rangeMin.x) / _steps;
-        float x = rangeMin.x;
-        float y = 0.0f;
+            if (refreshPending & Refresh_ViewY)
+            {
+                rangeMin.y = fmin(fmin(fmin(gdataLagrange.min, gdataNewtonFwd.min), gdataNewtonBwd.min), gdataSpline.min);
+                rangeMax.y = fmax(fmax(fmax(gdataLagrange.max, gdataNewtonFwd.max), gdataNewtonBwd.max), gdataSpline.max);
+            }
 
-        curIntp->datapointsEquidistant = true;
-        float dist;
-        if (curIntp->datapoints.size() >= 2)
-        {
-            dist = fabs(curIntp->datapoints[1].x - curIntp->datapoints[0].x);
+            if (refreshPending & (Refresh_Curves | Refresh_ViewY | Refresh_Detail))
+            {
+                refineGraphValues();
+            }
 
-            for (uint32_t i = 0; i < curIntp->datapoints.size() - 1; i++)
+            if (refreshPending & Refresh_Latex)
             {
-                if (dist != fabs(curIntp->datapoints[i + 1].x - curIntp->datapoints[i].x))
-                {
-                    curIntp->datapointsEquidistant = false;
-                    break;
-                }
+                refreshLatexFormulas(curVariant, false);
             }
         }
-        
-        gdataLagrange.yS.clear();
-        gdataLagrange.yS.reserve(_steps);
-        gdataLagrange.min = FLT_MAX;
-        gdataLagrange.max = 0;
 
-        gdataNewtonFwd.yS.clear();
-        gdataNewtonFwd.yS.reserve(_steps);
-        gdataNewtonFwd.min = FLT_MAX;
-        gdataNewtonFwd.max = 0;
+        refreshPending = Refresh_None;
+    }
 
-        gdataNewtonBwd.yS.clear();
-        gdataNewtonBwd.yS.reserve(_steps);
-        gdataNewtonBwd.min = FLT_MAX;
-        gdataNewtonBwd.max = 0;
+    void Renderer::refreshGraphValues()
+    {
+        if (NULL == curIntp) return;
 
-        for (int32_t i = 0; i < _steps; i++)
-        {
-            y = curIntp->evalLagrange(x);
-            gdataLagrange.min = fmin(gdataLagrange.min, y);
-            gdataLagrange.max = fmax(gdataLagrange.max, y);
-            gdataLagrange.yS.push_back(y);
+        GraphData*           gdatas[] = { &gdataLagrange, &gdataNewtonFwd, &gdataNewtonBwd, &gdataSpline };
+        InterpolationVariant variants[] = { Interpolation_Lagrange, Interpolation_NewtonFwd, Interpolation_NewtonBwd, Interpolation_Spline };
 
-            y = curIntp->evalNewtonFwd(x);
-            gdataNewtonFwd.min = fmin(gdataNewtonFwd.min, y);
-            gdataNewtonFwd.max = fmax(gdataNewtonFwd.max, y);
-            gdataNewtonFwd.yS.push_back(y);
+        // the base grid follows the graph width. refinement only splits where neighbouring samples
+        // disagree, so anything narrower than the grid spacing would slip between two of them.
+        uint32_t steps = (uint32_t)std::max(1.0f, graphSize.x / GRAPH_BASE_COLUMNS_PER_SAMPLE);
 
-            y = curIntp->evalNewtonBwd(x);
-            gdataNewtonBwd.min = fmin(gdataNewtonBwd.min, y);
-            gdataNewtonBwd.max = fmax(gdataNewtonBwd.max, y);
-            gdataNewtonBwd.yS.push_back(y);
+        sampler.sample(*curIntp, variants, gdatas, GRAPH_CURVES, rangeMin.x, rangeMax.x, steps, threadPool);
+    }
 
-            x += increment;
+    void Renderer::refineGraphValues()
+    {
+        if (NULL == curIntp) return;
+
+        GraphData* gdatas[] = { &gdataLagrange, &gdataNewtonFwd, &gdataNewtonBwd, &gdataSpline };
+
+        // tolerances are in plane units. intervals stop splitting at half a pixel column,
+        // so wherever the curve varies there is at least a sample per column.
+        float minDx = GRAPH_PIXEL_TOLERANCE * (rangeMax.x - rangeMin.x) / graphSize.x;
+        float tolY = GRAPH_PIXEL_TOLERANCE * (rangeMax.y - rangeMin.y) / graphSize.y;
+
+        sampler.refine(*curIntp, gdatas, minDx, tolY, rangeMin.y, rangeMax.y, GRAPH_REFINE_BUDGET, threadPool);
+
+        for (uint32_t c = 0; c < GRAPH_CURVES; c++)
+        {
+            CurveSampler::buildColumns(*gdatas[c], rangeMin.x, rangeMax.x, (uint32_t)graphSize.x);
         }
     }
 
@@ -756,32 +1168,68 @@ namespace finter
         bool newtonFwd = Interpolation_NewtonFwd == _variant;
         LatexData& _dataNw = newtonFwd ? latexNewtonFwd : latexNewtonBwd;
 
+        if (Interpolation_Spline != _variant && !curIntp->hasPolynomial())
+        {
+            LatexData& data = Interpolation_Lagrange == _variant ? latexLagrange : _dataNw;
+
+            data.px = "\\text{not computed for more than " + std::to_string(MAX_POLYNOMIAL_DATAPOINTS) + " datapoints}";
+            data.steps.assign(1, data.px);
+            return;
+        }
+
         if (_steps)
         {
             if (Interpolation_Lagrange == _variant)
             {
-                latexLagrange.steps.resize(curIntp->datapoints.size() + 1);
+                // the first basis polynomials only, like the spline pieces below.
+                uint32_t count = std::min<uint32_t>(curIntp->datapoints.size(), MAX_DATAPOINTS);
+
+                latexLagrange.steps.resize(count + 1);
 
                 Lagrange::latexFormula(curIntp->datapoints, latexLagrange.steps[0]);
 
-                for (uint32_t i = 0; i < curIntp->datapoints.size(); i++)
+                for (uint32_t i = 0; i < count; i++)
                 {
                     Lagrange::latexLx(curIntp->datapoints, i, latexLagrange.steps[i + 1]);
                 }
             }
+            else if (Interpolation_Spline == _variant)
+            {
+                curIntp->withState([&](auto& _s)
+                {
+                    // the first pieces only, there can be a lot more than anyone would read through.
+                    uint32_t pieces = std::min<uint32_t>(_s.spline.a.size(), MAX_DATAPOINTS);
+
+                    latexSpline.steps.resize(pieces + 1);
+                    Spline::latexPx(latexSpline.steps[0]);
+
+                    for (uint32_t i = 0; i < pieces; i++)
+                    {
+                        Spline::latexSx(_s.spline, i, latexSpline.steps[i + 1]);
+                    }
+                });
+            }
             else
             {
-                _dataNw.steps.resize(500);
-                Newton::latexFormula(curIntp->datapoints, curIntp->diffs, newtonFwd, _dataNw.steps[0]);
+                uint32_t n = curIntp->datapoints.size();
+
+                // one step per divided difference, n(n-1)/2 of them, of which only the first are shown.
+                uint32_t count = (uint32_t)std::min<size_t>((size_t)n * (n > 0 ? n - 1 : 0) / 2, MAX_DATAPOINTS);
 
-                s = 1;
-                for (uint32_t diffOrder = 1; diffOrder < curIntp->diffs.size(); diffOrder++)
+                _dataNw.steps.resize(count + 1);
+                curIntp->withState([&](auto& _s)
                 {
-                    for (uint32_t diffIndex = 0; diffIndex < curIntp->diffs[diffOrder].size(); diffIndex++)
+                    Newton::latexFormula(curIntp->datapoints, _s.diffs, newtonFwd, _dataNw.steps[0]);
+
+                    s = 1;
+                    for (uint32_t diffOrder = 1; diffOrder < n && s <= count; diffOrder++)
                     {
-                        Newton::latexFx(curIntp->datapoints, curIntp->diffs, newtonFwd, diffIndex, diffIndex + diffOrder, _dataNw.steps[s++]);
+                        for (uint32_t diffIndex = 0; diffIndex < n - diffOrder && s <= count; diffIndex++)
+                        {
+                            Newton::latexFx(curIntp->datapoints, _s.diffs, newtonFwd, diffIndex, diffIndex + diffOrder, _dataNw.steps[s++]);
+                        }
                     }
-                }
+                });
                 _dataNw.steps.resize(s);
             }
         }
@@ -791,9 +1239,13 @@ namespace finter
             {
                 Lagrange::latexPx(curIntp->datapoints, latexLagrange.px);
             }
+            else if (Interpolation_Spline == _variant)
+            {
+                Spline::latexPx(latexSpline.px);
+            }
             else
             {
-                Newton::latexPx(curIntp->datapoints, curIntp->diffs, newtonFwd, _dataNw.px);
+                curIntp->withState([&](auto& _s) { Newton::latexPx(curIntp->datapoints, _s.diffs, newtonFwd, _dataNw.px); });
             }
         }
     }
@@ -2,10 +2,14 @@
 #define RENDERER_H_
 
 #include "interpolator.h"
+#include "dataimport.h"
+#include "session.h"
+#include "threadpool.h"
+#include "sampler.h"
 #include "defines.h"
 #include "math.h"
 #include "imgui.h"
-#include "latex.hpp"
+#include "latexqueue.h"
 
 #include <map>
 #include <list>
@@ -13,17 +17,34 @@
 
 namespace finter
 {
+    enum RefreshFlags
+    {
+        Refresh_None = 0,
+        Refresh_Curves = 1 << 0,    // resample the curves over the x range.
+        Refresh_ViewY = 1 << 1,     // fit the y range to the sampled curves.
+        Refresh_Latex = 1 << 2,     // rebuild the formula of the current variant.
+        Refresh_Detail = 1 << 3,    // refine the curves again, e.g. the y scale changed.
+    };
+
     struct GraphOption
     {
         bool                        visible;
         ImVec4                      color;
     };
 
-    struct GraphData
+    // screen space geometry of a curve, kept until the samples or the view change.
+    struct CurveMesh
     {
-        std::vector<float>          yS;
-        float                       min;
-        float                       max;
+        CurveMesh() : version(0), pos(0, 0), size(0, 0), rangeMin(0, 0), rangeMax(0, 0), color(0) {}
+
+        ImVector<ImDrawVert>        vtx;
+        ImVector<ImDrawIdx>         idx;                        // relative to the first vertex of the mesh.
+        uint64_t                    version;                    // GraphData::version the mesh was built from.
+        ImVec2                      pos;                        // graph position, size and ranges it was built for.
+        ImVec2                      size;
+        ImVec2                      rangeMin;
+        ImVec2                      rangeMax;
+        ImU32                       color;
     };
 
     struct LatexData
@@ -52,10 +73,13 @@ namespace finter
         // internal state
         ID3D11Device*               device;                     // D3D11 device pointer.
 
-        Latex                       latex;                      // latex context instance.
+        LatexQueue                  latexQueue;                 // background renderer for latex formulas.
+
+        ThreadPool                  threadPool;                 // workers used for sampling the graph curves.
 
         Interpolator                interpolator;               // interpolations manager.
-        Interpolation*              curIntp;                    // current interpolation selected.
+        InterpolationHandle         curHandle;                  // current interpolation selected.
+        Interpolation*              curIntp;                    // curHandle looked up, again after anything adds or removes interpolations.
         ImVec2                      curPoint;                   // current point being evaluated (in plane space).
         InterpolationVariant        curVariant;                 // current interpolation variant tab active/selected.
 
@@ -68,10 +92,19 @@ namespace finter
         GraphData                   gdataLagrange;              // cached graph data for drawing lagrange poylnomial in the graph.
         GraphData                   gdataNewtonFwd;             // cached graph data for drawing newton forward poylnomial.
         GraphData                   gdataNewtonBwd;             // cached graph data for drawing newton backward polynomial .
+        GraphData                   gdataSpline;                // cached graph data for drawing the cubic spline.
+        CurveSampler                sampler;                    // keeps the curve samples around for reuse while panning/zooming.
+        std::vector<ImVec2>         curvePoints;                // scratch buffer for the curve polyline in screen space.
+        ImDrawList*                 curveBuilder;               // scratch draw list the curve meshes get tessellated in.
+        CurveMesh                   meshLagrange;               // cached geometry of the lagrange polynomial curve.
+        CurveMesh                   meshNewtonFwd;              // cached geometry of the newton forward polynomial curve.
+        CurveMesh                   meshNewtonBwd;              // cached geometry of the newton backward polynomial curve.
+        CurveMesh                   meshSpline;                 // cached geometry of the cubic spline curve.
 
         GraphOption                 goptLagrange;               // graph options for drawing lagrange polynomial curve.
         GraphOption                 goptNewtonFwd;              // graph options for drawing newton forward polynomial curve.
         GraphOption                 goptNewtonBwd;              // graph options for drawing newton backward polynomial curve.
+        GraphOption                 goptSpline;                 // graph options for drawing cubic spline curve.
         GraphOption                 goptAxes;                   // graph options for drawing graph axes.
         GraphOption                 goptDatapoints;             // graph options for drawing initial data points.
         GraphOption                 goptCurPoint;               // graph options for drawing the current point being evaluated on the left panel.
@@ -79,24 +112,43 @@ namespace finter
         LatexData                   latexLagrange;              // latex data for drawing math formulas for lagrange polynomial.
         LatexData                   latexNewtonFwd;             // latex data for drawing math formulas for newton forward polynomial.
         LatexData                   latexNewtonBwd;             // latex data for drawing math formulas for newton backward polynomial.
+        LatexData                   latexSpline;                // latex data for drawing math formulas for the cubic spline pieces.
 
         ImVec2                      mousePointLagrange;         // current point being hovered (in plane space).
         ImVec2                      mousePointNewtonFwd;        // current point being hovered (in plane space).
         ImVec2                      mousePointNewtonBwd;        // current point being hovered (in plane space).
+        ImVec2                      mousePointSpline;           // current point being hovered (in plane space).
+
+        uint32_t                    refreshPending;             // RefreshFlags invalidated during this frame, flushed at the end of it.
 
         bool                        stepByStepOpened;
 
         bool                        newIntpOpened;
-        Interpolation*              newIntp;
-        char                        newIntpBuff[INPUT_BUFFER_LEN];
+        Interpolation               newIntp;                    // being edited in the popup, moved into the interpolator once accepted.
+        std::string                 newIntpBuff;                // pasted datapoints, grows with the text.
+        std::string                 newIntpError;               // why the pasted datapoints were rejected, if they were.
+
+        bool                        importOpened;
+        DataImporter                importer;                   // loads datapoint files in the background.
+        std::string                 importPath;
+        int32_t                     importFormat;               // ImportFormat picked in the popup.
+        std::string                 importStatus;               // outcome of the last import.
+
+        bool                        sessionOpened;
+        std::string                 sessionPath;
+        std::string                 sessionStatus;              // outcome of the last save or open.
+        bool                        tabPending;                 // the tab of curVariant gets selected on the next frame, after opening a session.
 
         std::list<TextureData*>                 texLru;
         std::map<std::string, TextureData*>     texMap;
 
         // methods
-        void                        refreshGraphValues(uint32_t _steps = 1000);
+        void                        refreshGraphValues();
+        void                        refineGraphValues();
         void                        refreshLatexFormulas(InterpolationVariant _variant, bool _steps);
-        void                        resetView();
+        void                        refreshLatexTextures();
+        void                        flushRefresh();
+        inline void                 invalidate(uint32_t _flags) { refreshPending |= _flags; };
 
         // functions for converting from/to plane and screen coordinate spaces
         inline float                planeToScreenSpaceX(float _v) { return fmap(_v, rangeMin.x, rangeMax.x, 0, graphSize.x - 1, false) + 1; };
@@ -108,16 +160,20 @@ namespace finter
         inline bool                 isGraphPosX(float _x) { return _x >= graphPos.x && _x < graphPos.x + graphSize.x; };
         inline bool                 isGraphPosY(float _y) { return _y >= graphPos.y && _y < graphPos.y + graphSize.y; };
         void                        drawPopupNewInterpolation();
+        void                        drawPopupImport();
+        void                        pollImport();
+        void                        drawPopupSession();
         void                        drawPopupStepByStepSolution(const char* _name, LatexData& _data);
-        void                        drawListboxDataPoints(std::vector<ImVec2>& _data, ImVec2** _pointSelected);
-        bool                        drawListitemPoint(ImVec2& _p, bool* _isSelected);
+        void                        drawListboxDataPoints(Interpolation& _intp);
+        bool                        drawListitemPoint(uint32_t _id, ImVec2& _p, bool* _isSelected);
         void                        drawPanelLeft();
         void                        drawPanelMiddle();
         void                        drawPanelBottom();
-        bool                        drawTab(const char* _name, LatexData& _latex);
+        bool                        drawTab(const char* _name, InterpolationVariant _variant, LatexData& _latex);
         void                        drawGraphAxes(ImDrawList* _dl, const ImVec4& _color);
         void                        drawGraphPoint(ImDrawList * _dl, ImVec2& _p, bool _isSelected, ImVec4& _color, bool _square = false, float _radius = 4.0f);
-        void                        drawGraphCurve(std::vector<float>& _yValues, float _yMin, float _yMax, const ImVec4& _color, const ImVec2& _size);
+        void                        drawGraphCurves(ImDrawList* _dl);
+        void                        buildCurveMesh(GraphData& _data, const ImVec4& _color, CurveMesh& _mesh);
         void                        drawOption(const char* _label, GraphOption& _opt);
         void                        drawLatex(const char* _latex);
         
@@ -126,7 +182,7 @@ namespace finter
         static void                 popDisabled();
         static void                 helpMarker(const char* _desc);
 
-        bool                        loadTextureFromFile(const char* filename, ID3D11ShaderResourceView** out_srv, int* out_width, int* out_height);
+        bool                        createTexture(const unsigned char* _pixels, int32_t _w, int32_t _h, ID3D11ShaderResourceView** _outSrv);
     };
 }
 
@@ -0,0 +1,417 @@
+#include "sampler.h"
+#include "defines.h"
+
+#include <algorithm>
+#include <cmath>
+#include <float.h>
+#include <string.h>
+
+namespace finter
+{
+    CurveSampler::CurveSampler()
+    {
+        revision = 0;
+        tick = 0;
+        base = nullptr;
+        refined.revision = 0;
+
+        // levels are only ever added up to this, so base (pointing into it) stays valid
+        levels.reserve(SAMPLER_CACHE_LEVELS);
+    }
+
+    CurveSampler::~CurveSampler()
+    {
+    }
+
+    void CurveSampler::clear()
+    {
+        levels.clear();
+        variants.clear();
+        revision = 0;
+        base = nullptr;
+        refined.revision = 0;
+    }
+
+    void CurveSampler::sample(Interpolation& _intp, const InterpolationVariant* _variants, GraphData** _outData, uint32_t _curves,
+        float _xMin, float _xMax, uint32_t _steps, ThreadPool& _pool)
+    {
+        if (_intp.revision != revision || variants.size() != _curves || !std::equal(variants.begin(), variants.end(), _variants))
+        {
+            clear();
+            revision = _intp.revision;
+            variants.assign(_variants, _variants + _curves);
+        }
+
+        base = nullptr;
+
+        for (uint32_t c = 0; c < _curves; c++)
+        {
+            _outData[c]->xS.clear();
+            _outData[c]->yS.clear();
+            _outData[c]->min = FLT_MAX;
+            _outData[c]->max = -FLT_MAX;
+        }
+
+        if (!(_xMax > _xMin) || 0 == _steps) return;
+
+        // largest power of two spacing which still gives at least _steps samples
+        int32_t level = (int32_t)std::floor(std::log2(((double)_xMax - _xMin) / _steps));
+        double  h = std::ldexp(1.0, level);
+        int64_t kBegin = (int64_t)std::ceil(_xMin / h);
+        int64_t kEnd = (int64_t)std::floor(_xMax / h) + 1;
+        int64_t k;
+
+        std::vector<std::vector<float>> ys(_curves, std::vector<float>(kEnd - kBegin));
+
+        Level* cur = findLevel(level);
+        Level* coarse = findLevel(level + 1);
+        Level* fine = findLevel(level - 1);
+
+        // what's still there from the last view at this level is one contiguous block
+        int64_t keepBegin = kBegin;
+        int64_t keepEnd = kBegin;
+
+        if (nullptr != cur)
+        {
+            keepBegin = cur->kBegin > kBegin ? cur->kBegin : kBegin;
+            keepEnd = cur->kEnd < kEnd ? cur->kEnd : kEnd;
+
+            if (keepBegin < keepEnd)
+            {
+                for (uint32_t c = 0; c < _curves; c++)
+                {
+                    memcpy(ys[c].data() + (keepBegin - kBegin), cur->ys[c].data() + (keepBegin - cur->kBegin), (keepEnd - keepBegin) * sizeof(float));
+                }
+            }
+            else
+            {
+                keepEnd = keepBegin = kBegin;
+            }
+        }
+
+        // the rest comes from the neighbour levels when they have it (every other sample
+        // of the finer one, or all even k of the coarser one), otherwise it gets evaluated.
+        missing.clear();
+        evalXs.resize(_curves);
+        evalXs[0].clear();
+
+        for (k = kBegin; k < kEnd; k++)
+        {
+            if (k == keepBegin && keepBegin < keepEnd)
+            {
+                k = keepEnd - 1;
+                continue;
+            }
+
+            uint32_t i = (uint32_t)(k - kBegin);
+
+            if (nullptr != coarse && 0 == k % 2 && k / 2 >= coarse->kBegin && k / 2 < coarse->kEnd)
+            {
+                for (uint32_t c = 0; c < _curves; c++) ys[c][i] = coarse->ys[c][k / 2 - coarse->kBegin];
+            }
+            else if (nullptr != fine && 2 * k >= fine->kBegin && 2 * k < fine->kEnd)
+            {
+                for (uint32_t c = 0; c < _curves; c++) ys[c][i] = fine->ys[c][2 * k - fine->kBegin];
+            }
+            else
+            {
+                missing.push_back(i);
+                evalXs[0].push_back((float)(k * h));
+            }
+        }
+
+        if (missing.size() > 0)
+        {
+            for (uint32_t c = 1; c < _curves; c++) evalXs[c] = evalXs[0];
+
+            evalBatch(_intp, _pool);
+
+            for (uint32_t c = 0; c < _curves; c++)
+            {
+                for (uint32_t j = 0; j < missing.size(); j++) ys[c][missing[j]] = evalYs[c][j];
+            }
+        }
+
+        for (uint32_t c = 0; c < _curves; c++)
+        {
+            GraphData* g = _outData[c];
+
+            g->xS.resize(kEnd - kBegin);
+            g->yS = ys[c];
+
+            for (uint32_t i = 0; i < g->yS.size(); i++)
+            {
+                g->xS[i] = (float)((kBegin + i) * h);
+
+                // NaNs fail both comparisons, so they never end up in the range
+                g->min = g->yS[i] < g->min ? g->yS[i] : g->min;
+                g->max = g->yS[i] > g->max ? g->yS[i] : g->max;
+            }
+        }
+
+        storeLevel(level, kBegin, kEnd, ys);
+        base = findLevel(level);
+    }
+
+    void CurveSampler::refine(Interpolation& _intp, GraphData** _outData, float _minDx, float _tolY, float _yMin, float _yMax,
+        uint32_t _budget, ThreadPool& _pool)
+    {
+        if (nullptr == base || _intp.revision != revision) return;
+
+        uint32_t curves = variants.size();
+        uint32_t n = base->kEnd - base->kBegin;
+        double   h = std::ldexp(1.0, base->level);
+        int64_t  k;
+
+        // panning keeps the grid level and the pixel size, so the intervals the last refinement
+        // went through come out exactly the same. those are copied over instead.
+        bool reuse = refined.revision == revision && refined.level == base->level
+            && refined.minDx == _minDx && refined.tolY == _tolY && refined.yMin == _yMin && refined.yMax == _yMax;
+
+        std::vector<std::vector<Point>> points(curves);
+        pending.resize(curves);
+        tested.resize(curves);
+        evalXs.resize(curves);
+
+        for (uint32_t c = 0; c < curves; c++)
+        {
+            std::vector<float>& ys = base->ys[c];
+            const Point*        prev = reuse ? refined.points[c].data() : nullptr;
+            const Point*        prevEnd = reuse ? prev + refined.points[c].size() : nullptr;
+            Interval            iv;
+
+            pending[c].clear();
+            points[c].reserve(n * 2);
+
+            for (uint32_t i = 0; i < n; i++)
+            {
+                k = base->kBegin + i;
+                iv.x0 = (float)(k * h);
+                iv.y0 = ys[i];
+                points[c].push_back({ iv.x0, iv.y0 });
+
+                if (i + 1 == n) break;
+
+                iv.x1 = (float)((k + 1) * h);
+                iv.y1 = ys[i + 1];
+
+                if (reuse && k >= refined.kBegin && k + 1 < refined.kEnd)
+                {
+                    while (prev < prevEnd && prev->x <= iv.x0) prev++;
+                    while (prev < prevEnd && prev->x < iv.x1) points[c].push_back(*prev++);
+                }
+                else if (0.5f * (iv.x1 - iv.x0) >= _minDx)
+                {
+                    pending[c].push_back(iv);
+                }
+            }
+        }
+
+        // breadth first, so running out of budget leaves the whole curve equally refined
+        // instead of just its left end. every midpoint evaluated is a point of the polyline.
+        std::vector<uint32_t> spent(curves, 0);
+        bool more = true;
+
+        while (more)
+        {
+            more = false;
+
+            for (uint32_t c = 0; c < curves; c++)
+            {
+                uint32_t take = (uint32_t)pending[c].size() < _budget - spent[c] ? (uint32_t)pending[c].size() : _budget - spent[c];
+
+                tested[c].assign(pending[c].begin(), pending[c].begin() + take);
+                pending[c].clear();
+                spent[c] += take;
+
+                evalXs[c].resize(take);
+                for (uint32_t i = 0; i < take; i++) evalXs[c][i] = 0.5f * (tested[c][i].x0 + tested[c][i].x1);
+            }
+
+            evalBatch(_intp, _pool);
+
+            for (uint32_t c = 0; c < curves; c++)
+            {
+                for (uint32_t i = 0; i < tested[c].size(); i++)
+                {
+                    Interval& iv = tested[c][i];
+                    float     xm = evalXs[c][i];
+                    float     ym = evalYs[c][i];
+                    float     err = fabsf(ym - 0.5f * (iv.y0 + iv.y1));
+                    bool      above = iv.y0 > _yMax && ym > _yMax && iv.y1 > _yMax;
+                    bool      below = iv.y0 < _yMin && ym < _yMin && iv.y1 < _yMin;
+
+                    points[c].push_back({ xm, ym });
+
+                    // NaN errors fail the comparison, so undefined parts are never split
+                    if (err > _tolY && !above && !below && 0.5f * (iv.x1 - iv.x0) >= _minDx)
+                    {
+                        pending[c].push_back({ iv.x0, iv.y0, xm, ym });
+                        pending[c].push_back({ xm, ym, iv.x1, iv.y1 });
+                    }
+                }
+
+                more = more || (pending[c].size() > 0 && spent[c] < _budget);
+            }
+        }
+
+        for (uint32_t c = 0; c < curves; c++)
+        {
+            std::vector<Point>& p = points[c];
+            GraphData*          g = _outData[c];
+
+            std::sort(p.begin(), p.end(), [](const Point& _a, const Point& _b) { return _a.x < _b.x; });
+
+            g->xS.resize(p.size());
+            g->yS.resize(p.size());
+            g->min = FLT_MAX;
+            g->max = -FLT_MAX;
+
+            for (uint32_t i = 0; i < p.size(); i++)
+            {
+                g->xS[i] = p[i].x;
+                g->yS[i] = p[i].y;
+                g->min = p[i].y < g->min ? p[i].y : g->min;
+                g->max = p[i].y > g->max ? p[i].y : g->max;
+            }
+        }
+
+        refined.revision = revision;
+        refined.level = base->level;
+        refined.kBegin = base->kBegin;
+        refined.kEnd = base->kEnd;
+        refined.minDx = _minDx;
+        refined.tolY = _tolY;
+        refined.yMin = _yMin;
+        refined.yMax = _yMax;
+        refined.points.swap(points);
+    }
+
+    inline static void addToColumn(GraphColumn& _col, float _y)
+    {
+        if (std::isnan(_col.first))
+        {
+            _col.first = _col.last = _col.min = _col.max = _y;
+        }
+        else
+        {
+            _col.last = _y;
+            _col.min = _y < _col.min ? _y : _col.min;
+            _col.max = _y > _col.max ? _y : _col.max;
+        }
+    }
+
+    void CurveSampler::buildColumns(GraphData& _data, float _xMin, float _xMax, uint32_t _columns)
+    {
+        const GraphColumn undefined = { NAN, NAN, NAN, NAN };
+
+        _data.columns.assign(_columns, undefined);
+        _data.columnsX = _xMin;
+        _data.columnsDx = (_xMax - _xMin) / _columns;
+        _data.version++;
+
+        if (0 == _columns || !(_xMax > _xMin)) return;
+
+        float    dx = _data.columnsDx;
+        float    x0, y0, x1, y1, xa, xb;
+        int64_t  c0, c1;
+
+        // every segment adds the part of it inside each column it crosses. segments come in
+        // ascending x, so the first/last values of a column are where the curve enters/leaves it.
+        for (uint32_t i = 0; i + 1 < _data.xS.size(); i++)
+        {
+            x0 = _data.xS[i];
+            y0 = _data.yS[i];
+            x1 = _data.xS[i + 1];
+            y1 = _data.yS[i + 1];
+
+            if (std::isnan(y0) || std::isnan(y1) || x1 < _xMin || x0 >= _xMax) continue;
+
+            c0 = (int64_t)std::floor((x0 - _xMin) / dx);
+            c1 = (int64_t)std::floor((x1 - _xMin) / dx);
+            c0 = c0 < 0 ? 0 : c0;
+            c1 = c1 < _columns ? c1 : _columns - 1;
+
+            for (int64_t c = c0; c <= c1; c++)
+            {
+                xa = _xMin + c * dx;
+                xb = xa + dx;
+                xa = x0 > xa ? x0 : xa;
+                xb = x1 < xb ? x1 : xb;
+
+                addToColumn(_data.columns[c], x1 > x0 ? y0 + (y1 - y0) * (xa - x0) / (x1 - x0) : y0);
+                addToColumn(_data.columns[c], x1 > x0 ? y0 + (y1 - y0) * (xb - x0) / (x1 - x0) : y1);
+            }
+        }
+    }
+
+    void CurveSampler::evalBatch(Interpolation& _intp, ThreadPool& _pool)
+    {
+        uint32_t curves = variants.size();
+        size_t   total = 0;
+
+        evalYs.resize(curves);
+        for (uint32_t c = 0; c < curves; c++)
+        {
+            evalYs[c].resize(evalXs[c].size());
+            total += evalXs[c].size();
+        }
+
+        if (0 == total) return;
+
+        // every curve gets split in chunks which are spread across the worker pool.
+        // small workloads aren't worth waking the workers up, so they stay in one chunk.
+        uint32_t chunks = (_intp.datapoints.size() * total >= GRAPH_PARALLEL_MIN_WORK) ? _pool.getThreadCount() : 1;
+
+        _pool.parallelFor(curves * chunks, [&](uint32_t _task)
+        {
+            uint32_t c = _task / chunks;
+            uint32_t n = evalXs[c].size();
+            uint32_t chunkLen = (n + chunks - 1) / chunks;
+            uint32_t from = (_task % chunks) * chunkLen;
+            uint32_t to = from + chunkLen < n ? from + chunkLen : n;
+
+            if (from < to)
+                _intp.evalMany(variants[c], evalXs[c].data() + from, evalYs[c].data() + from, to - from);
+        });
+    }
+
+    CurveSampler::Level* CurveSampler::findLevel(int32_t _level)
+    {
+        for (auto it = levels.begin(); it != levels.end(); ++it)
+        {
+            if (it->level == _level) return &(*it);
+        }
+
+        return nullptr;
+    }
+
+    void CurveSampler::storeLevel(int32_t _level, int64_t _kBegin, int64_t _kEnd, std::vector<std::vector<float>>& _ys)
+    {
+        Level* l = findLevel(_level);
+
+        if (nullptr == l)
+        {
+            if (levels.size() < SAMPLER_CACHE_LEVELS)
+            {
+                levels.emplace_back();
+                l = &levels.back();
+            }
+            else
+            {
+                // reuse the least recently used level
+                l = &levels[0];
+                for (auto it = levels.begin(); it != levels.end(); ++it)
+                {
+                    if (it->lastUsed < l->lastUsed) l = &(*it);
+                }
+            }
+        }
+
+        l->level = _level;
+        l->kBegin = _kBegin;
+        l->kEnd = _kEnd;
+        l->lastUsed = tick++;
+        l->ys.swap(_ys);
+    }
+}
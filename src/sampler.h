@@ -0,0 +1,125 @@
+#ifndef SAMPLER_H_
+#define SAMPLER_H_
+
+#include "interpolator.h"
+#include "threadpool.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace finter
+{
+    // what the curve does inside one pixel column: where it enters and leaves it,
+    // and the range it sweeps in between. all NaN if it's undefined there.
+    struct GraphColumn
+    {
+        float                       first;
+        float                       last;
+        float                       min;
+        float                       max;
+    };
+
+    struct GraphData
+    {
+        GraphData() : min(0.0f), max(0.0f), columnsX(0.0f), columnsDx(0.0f), version(0) {}
+
+        std::vector<float>          xS;                         // abscissas of the curve polyline, ascending.
+        std::vector<float>          yS;
+        float                       min;
+        float                       max;
+
+        std::vector<GraphColumn>    columns;                    // the polyline reduced to one entry per pixel column.
+        float                       columnsX;                   // abscissa where the first column starts.
+        float                       columnsDx;                  // width of a column.
+        uint64_t                    version;                    // bumped whenever the columns are rebuilt.
+    };
+
+    // samples interpolation curves over an x range, in two steps:
+    //
+    // sample() takes a coarse base on a fixed grid, x = k * 2^level, with the level picked so
+    // that between _steps and 2 * _steps points fall in range. since the grid doesn't move
+    // along with the view, the samples of every level are kept around and reused: panning only
+    // evaluates the newly exposed strip, and zooming in or out picks every other sample up from
+    // the finer or coarser level.
+    //
+    // refine() then subdivides the base intervals where drawing them as a straight line would
+    // be off by more than a given tolerance, so flat parts stay cheap and wild ones get all the
+    // samples they need. its result is reused the same way while panning.
+    class CurveSampler
+    {
+    public:
+                                    CurveSampler();
+                                    ~CurveSampler();
+
+        // samples the base of _curves variants of _intp into _outData. the cache is dropped
+        // whenever the interpolation (its revision) or the variants change.
+        void                        sample(Interpolation& _intp, const InterpolationVariant* _variants, GraphData** _outData, uint32_t _curves,
+                                        float _xMin, float _xMax, uint32_t _steps, ThreadPool& _pool);
+
+        // rebuilds _outData from the last base, splitting intervals in halves until their midpoint
+        // is within _tolY of the straight line, their halves would be narrower than _minDx, or they
+        // lie entirely outside [_yMin, _yMax]. at most _budget evaluations are spent per curve.
+        void                        refine(Interpolation& _intp, GraphData** _outData, float _minDx, float _tolY, float _yMin, float _yMax,
+                                        uint32_t _budget, ThreadPool& _pool);
+
+        void                        clear();
+
+        // reduces the polyline of _data to _columns equally wide columns over [_xMin, _xMax).
+        static void                 buildColumns(GraphData& _data, float _xMin, float _xMax, uint32_t _columns);
+
+    private:
+        struct Level
+        {
+            int32_t                         level;
+            int64_t                         kBegin;             // grid index of the first sample kept.
+            int64_t                         kEnd;               // grid index past the last sample kept.
+            uint64_t                        lastUsed;
+            std::vector<std::vector<float>> ys;                 // samples of every curve in [kBegin, kEnd).
+        };
+
+        struct Interval
+        {
+            float                           x0, y0;
+            float                           x1, y1;
+        };
+
+        struct Point
+        {
+            float                           x, y;
+        };
+
+        struct Refinement
+        {
+            uint64_t                        revision;
+            int32_t                         level;
+            int64_t                         kBegin;
+            int64_t                         kEnd;
+            float                           minDx;
+            float                           tolY;
+            float                           yMin;
+            float                           yMax;
+            std::vector<std::vector<Point>> points;             // refined polyline of every curve.
+        };
+
+        std::vector<Level>                  levels;
+        std::vector<InterpolationVariant>   variants;           // variants the cached samples were taken for.
+        uint64_t                            revision;           // revision of the interpolation the cached samples belong to.
+        uint64_t                            tick;
+
+        Level*                              base;               // level holding the last base, if any.
+        Refinement                          refined;            // last refine() result, reused while only panning.
+
+        // scratch buffers for batched evaluations, one list per curve
+        std::vector<std::vector<float>>     evalXs;
+        std::vector<std::vector<float>>     evalYs;
+        std::vector<uint32_t>               missing;
+        std::vector<std::vector<Interval>>  pending;
+        std::vector<std::vector<Interval>>  tested;
+
+        Level*                      findLevel(int32_t _level);
+        void                        storeLevel(int32_t _level, int64_t _kBegin, int64_t _kEnd, std::vector<std::vector<float>>& _ys);
+        void                        evalBatch(Interpolation& _intp, ThreadPool& _pool);
+    };
+}
+
+#endif // SAMPLER_H_
@@ -0,0 +1,327 @@
+#include "session.h"
+#include "mappedfile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+
+#define SESSION_MAGIC "FSES"
+#define SESSION_VERSION 1
+#define SESSION_ALIGNMENT 16
+
+namespace finter
+{
+    struct SessionHeader
+    {
+        char                            magic[4];
+        uint32_t                        version;
+        uint32_t                        count;
+        uint32_t                        entrySize;
+        SessionView                     view;
+    };
+
+    struct SessionBlob
+    {
+        uint64_t                        offset;                    // from the start of the file.
+        uint64_t                        count;                     // elements, not bytes.
+    };
+
+    enum SessionFlags
+    {
+        Session_Equidistant = 1 << 0,
+        Session_Compensated = 1 << 1,
+        Session_Chebyshev = 1 << 2,
+        Session_Monomials = 1 << 3,
+    };
+
+    struct SessionEntry
+    {
+        char                            name[INTERPOLATION_NAME_LEN];
+        uint32_t                        precision;
+        uint32_t                        valueSize;                 // sizeof the precision's type in the build that saved it.
+        uint32_t                        flags;                     // SessionFlags.
+        uint32_t                        splineBoundary;
+        float                           splineSlopeStart;
+        float                           splineSlopeEnd;
+        float                           spacing;
+        float                           splineStep;
+        SessionBlob                     datapoints;
+        SessionBlob                     weights;
+        SessionBlob                     knots;
+        SessionBlob                     splineA;
+        SessionBlob                     splineB;
+        SessionBlob                     splineC;
+        SessionBlob                     splineD;
+        uint8_t                         weightsScale[16];          // T value, valueSize bytes of it are used.
+    };
+
+    // appends arrays to the file, each at the next aligned offset.
+    class SessionWriter
+    {
+    public:
+        SessionWriter(FILE* _f, uint64_t _offset) : f(_f), offset(_offset), ok(true) {}
+
+        template <typename T>
+        SessionBlob write(const std::vector<T>& _v)
+        {
+            static const uint8_t zeros[SESSION_ALIGNMENT] = {};
+            SessionBlob blob = { 0, _v.size() };
+
+            if (0 == _v.size()) return blob;
+
+            size_t pad = (SESSION_ALIGNMENT - offset % SESSION_ALIGNMENT) % SESSION_ALIGNMENT;
+            ok = ok && pad == fwrite(zeros, 1, pad, f);
+            offset += pad;
+
+            blob.offset = offset;
+            ok = ok && _v.size() == fwrite(_v.data(), sizeof(T), _v.size(), f);
+            offset += sizeof(T) * _v.size();
+
+            return blob;
+        }
+
+        FILE*                           f;
+        uint64_t                        offset;
+        bool                            ok;
+    };
+
+    template <typename T>
+    static bool readBlob(const uint8_t* _data, size_t _size, const SessionBlob& _blob, std::vector<T>& _out)
+    {
+        if (_blob.offset > _size || _blob.count > (_size - _blob.offset) / sizeof(T)) return false;
+
+        _out.resize((size_t)_blob.count);
+        if (_blob.count > 0) memcpy(_out.data(), _data + _blob.offset, (size_t)_blob.count * sizeof(T));
+
+        return true;
+    }
+
+    template <typename T>
+    static void saveState(InterpolationState<T>& _state, SessionEntry& _entry, SessionWriter& _writer)
+    {
+        _entry.valueSize = sizeof(T);
+        _entry.weights = _writer.write(_state.weights);
+        _entry.knots = _writer.write(_state.spline.knots);
+        _entry.splineA = _writer.write(_state.spline.a);
+        _entry.splineB = _writer.write(_state.spline.b);
+        _entry.splineC = _writer.write(_state.spline.c);
+        _entry.splineD = _writer.write(_state.spline.d);
+        _entry.splineStep = _state.spline.step;
+
+        memcpy(_entry.weightsScale, &_state.weightsScale, sizeof(T));
+    }
+
+    // returns false if the saved state can't be used as it is, it then has to be recalculated.
+    template <typename T>
+    static bool loadState(const uint8_t* _data, size_t _size, const SessionEntry& _entry, uint32_t _count, InterpolationState<T>& _outState)
+    {
+        if (sizeof(T) != _entry.valueSize || sizeof(T) > sizeof(_entry.weightsScale)) return false;
+
+        CubicSpline<T>& spline = _outState.spline;
+
+        bool ok = readBlob(_data, _size, _entry.weights, _outState.weights)
+            && readBlob(_data, _size, _entry.knots, spline.knots)
+            && readBlob(_data, _size, _entry.splineA, spline.a)
+            && readBlob(_data, _size, _entry.splineB, spline.b)
+            && readBlob(_data, _size, _entry.splineC, spline.c)
+            && readBlob(_data, _size, _entry.splineD, spline.d);
+
+        if (!ok) return false;
+
+        memcpy(&_outState.weightsScale, _entry.weightsScale, sizeof(T));
+        spline.step = _entry.splineStep;
+
+        // the weights are there unless past the polynomial datapoints limit.
+        size_t pieces = spline.a.size();
+
+        return (_count <= MAX_POLYNOMIAL_DATAPOINTS ? _outState.weights.size() == _count : _outState.weights.empty())
+            && spline.b.size() == pieces && spline.c.size() == pieces && spline.d.size() == pieces
+            && (spline.knots.size() == pieces + 1 || (pieces <= 1 && spline.knots.size() == pieces));
+    }
+
+    bool Session::save(const char* _path, Interpolator& _interpolator, const SessionView& _view)
+    {
+        // write aside and swap it in, so a failed save never leaves a broken session behind
+        std::string tmpPath = std::string(_path) + ".tmp";
+        FILE* f = fopen(tmpPath.c_str(), "wb");
+        if (nullptr == f) return false;
+
+        uint32_t                  count = _interpolator.getCount();
+        std::vector<SessionEntry> entries(count);
+        SessionHeader             header;
+
+        memcpy(header.magic, SESSION_MAGIC, sizeof(header.magic));
+        header.version = SESSION_VERSION;
+        header.count = count;
+        header.entrySize = sizeof(SessionEntry);
+        header.view = _view;
+
+        // the entries go first but point at the arrays after them, they get written once those are.
+        SessionWriter writer(f, sizeof(SessionHeader) + (uint64_t)count * sizeof(SessionEntry));
+        writer.ok = fileSeek(f, writer.offset);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Interpolation& intp = _interpolator.getAt(i);
+            SessionEntry&  e = entries[i];
+
+            memset(&e, 0, sizeof(e));
+            memcpy(e.name, intp.name, sizeof(e.name));
+            e.precision = intp.precision;
+            e.splineBoundary = intp.splineBoundary;
+            e.splineSlopeStart = intp.splineSlopeStart;
+            e.splineSlopeEnd = intp.splineSlopeEnd;
+            e.spacing = intp.datapointsSpacing;
+            e.flags = (intp.datapointsEquidistant ? Session_Equidistant : 0)
+                | (intp.compensated ? Session_Compensated : 0)
+                | (intp.chebyshevEnabled ? Session_Chebyshev : 0)
+                | (intp.monomialsEnabled ? Session_Monomials : 0);
+
+            e.datapoints = writer.write(intp.datapoints);
+            intp.withState([&](auto& _s) { saveState(_s, e, writer); });
+        }
+
+        bool ok = writer.ok
+            && fileSeek(f, 0)
+            && 1 == fwrite(&header, sizeof(header), 1, f)
+            && entries.size() == fwrite(entries.data(), sizeof(SessionEntry), entries.size(), f);
+
+        ok = 0 == fclose(f) && ok;
+
+        if (ok)
+        {
+            remove(_path);
+            ok = 0 == rename(tmpPath.c_str(), _path);
+        }
+
+        if (!ok) remove(tmpPath.c_str());
+
+        return ok;
+    }
+
+    bool Session::load(const char* _path, Interpolator& _outInterpolator, SessionView& _outView, std::string& _outError, ThreadPool& _pool)
+    {
+        MappedFile file;
+        if (!file.open(_path))
+        {
+            _outError = "could not open the file";
+            return false;
+        }
+
+        const uint8_t* data = file.getData();
+        size_t         size = file.getSize();
+        SessionHeader  header;
+
+        if (size < sizeof(SessionHeader))
+        {
+            _outError = "not a session file";
+            return false;
+        }
+
+        memcpy(&header, data, sizeof(header));
+
+        if (0 != memcmp(header.magic, SESSION_MAGIC, sizeof(header.magic)))
+        {
+            _outError = "not a session file";
+            return false;
+        }
+
+        if (SESSION_VERSION != header.version || sizeof(SessionEntry) != header.entrySize)
+        {
+            _outError = "unsupported session version";
+            return false;
+        }
+
+        // the graph can't be sampled over a range that is empty or not finite.
+        const SessionView& v = header.view;
+        if (!std::isfinite(v.rangeMin.x) || !std::isfinite(v.rangeMax.x) || !(v.rangeMax.x > v.rangeMin.x)
+            || !std::isfinite(v.rangeMin.y) || !std::isfinite(v.rangeMax.y) || !(v.rangeMax.y > v.rangeMin.y))
+        {
+            _outError = "not a session file";
+            return false;
+        }
+
+        if (size < sizeof(SessionHeader) + (uint64_t)header.count * sizeof(SessionEntry))
+        {
+            _outError = "the file is truncated";
+            return false;
+        }
+
+        // every array must lie within the file before anything gets replaced.
+        const uint8_t* entries = data + sizeof(SessionHeader);
+        SessionEntry   e;
+
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            memcpy(&e, entries + (size_t)i * sizeof(SessionEntry), sizeof(e));
+
+            const SessionBlob* blobs[] = { &e.datapoints, &e.weights, &e.knots, &e.splineA, &e.splineB, &e.splineC, &e.splineD };
+            const size_t       sizes[] = { sizeof(Vec2), e.valueSize, sizeof(float), e.valueSize, e.valueSize, e.valueSize, e.valueSize };
+
+            for (uint32_t b = 0; b < sizeof(blobs) / sizeof(blobs[0]); b++)
+            {
+                if (blobs[b]->offset > size || (0 != sizes[b] && blobs[b]->count > (size - blobs[b]->offset) / sizes[b]))
+                {
+                    _outError = "the file is truncated";
+                    return false;
+                }
+            }
+        }
+
+        _outInterpolator.clear();
+
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            _outInterpolator.emplace();
+        }
+
+        // filled in place, so the arrays are only copied once, from the mapping. the interpolations
+        // don't share anything, they can be restored in parallel.
+        _pool.parallelFor(header.count, [&](uint32_t _i)
+        {
+            Interpolation& intp = _outInterpolator.getAt(_i);
+            SessionEntry   e;
+
+            memcpy(&e, entries + (size_t)_i * sizeof(SessionEntry), sizeof(e));
+            e.name[INTERPOLATION_NAME_LEN - 1] = '\0';
+
+            readBlob(data, size, e.datapoints, intp.datapoints);
+            memcpy(intp.name, e.name, sizeof(intp.name));
+            intp.precision = (InterpolationPrecision)std::min<uint32_t>(e.precision, Precision_LongDouble);
+            intp.splineBoundary = Spline_Clamped == e.splineBoundary ? Spline_Clamped : Spline_Natural;
+            intp.splineSlopeStart = e.splineSlopeStart;
+            intp.splineSlopeEnd = e.splineSlopeEnd;
+            intp.datapointsSpacing = e.spacing;
+            intp.datapointsEquidistant = 0 != (e.flags & Session_Equidistant);
+            intp.compensated = 0 != (e.flags & Session_Compensated);
+            intp.chebyshevEnabled = 0 != (e.flags & Session_Chebyshev);
+            intp.monomialsEnabled = 0 != (e.flags & Session_Monomials);
+
+            bool cached = false;
+            intp.withState([&](auto& _s) { cached = loadState(data, size, e, intp.datapoints.size(), _s); });
+
+            if (!cached)
+            {
+                intp.stateF = InterpolationState<float>();
+                intp.stateD = InterpolationState<double>();
+                intp.stateLD = InterpolationState<long double>();
+                intp.recalculate();
+                return;
+            }
+
+            // the newton table is quadratic in the datapoints, so it's faster to rebuild it than
+            // to read it back, and the same goes for the (small) monomials and chebyshev series.
+            intp.recalculateDiffs();
+
+            if (intp.monomialsEnabled)
+                intp.recalculateMonomials();
+
+            if (intp.chebyshevEnabled)
+                intp.recalculateChebyshev();
+        });
+
+        _outView = header.view;
+        return true;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef SESSION_H_
+#define SESSION_H_
+
+#include "interpolator.h"
+#include "threadpool.h"
+#include "vec2.h"
+
+#include <string>
+#include <stdint.h>
+
+namespace finter
+{
+    // what the renderer was showing when the session was saved.
+    struct SessionView
+    {
+        Vec2                            rangeMin;
+        Vec2                            rangeMax;
+        uint32_t                        selected;                  // index of the current interpolation, UINT32_MAX if none.
+        uint32_t                        variant;                   // InterpolationVariant of the active tab.
+    };
+
+    // saves and loads every interpolation of an Interpolator to a single binary file.
+    //
+    // a header and a fixed size entry per interpolation are followed by the arrays (datapoints,
+    // weights, spline coefficients) as they are in memory, each aligned to 16 bytes. loading maps
+    // the file and copies every array over in one go. only the newton table is rebuilt (it is
+    // quadratic in size), unless the state was saved in a precision whose size differs in this
+    // build (long double), which gets recalculated entirely.
+    class Session
+    {
+    public:
+        static bool                     save(const char* _path, Interpolator& _interpolator, const SessionView& _view);
+
+        // replaces the interpolations of _outInterpolator with the saved ones. a file that fails to
+        // load leaves them untouched. what has to be rebuilt is spread across _pool.
+        static bool                     load(const char* _path, Interpolator& _outInterpolator, SessionView& _outView, std::string& _outError, ThreadPool& _pool);
+    };
+}
+
+#endif // SESSION_H_
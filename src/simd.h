@@ -0,0 +1,44 @@
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   define FINTER_SIMD_X86 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   endif
+#else
+#   define FINTER_SIMD_X86 0
+#endif
+
+// msvc lets us use any intrinsic in any function, gcc and clang need the
+// functions using wider instruction sets than the baseline to be tagged.
+#if FINTER_SIMD_X86 && !defined(_MSC_VER)
+#   define FINTER_TARGET_AVX __attribute__((target("avx")))
+#else
+#   define FINTER_TARGET_AVX
+#endif
+
+namespace finter
+{
+    // true if both the cpu and the os (ymm state saving) support AVX.
+    inline bool cpuHasAvx()
+    {
+#if FINTER_SIMD_X86 && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#elif FINTER_SIMD_X86
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx");
+#else
+        return false;
+#endif
+    }
+}
+
+#endif // SIMD_H_
@@ -0,0 +1,121 @@
+#include "threadpool.h"
+
+namespace finter
+{
+    ThreadPool::ThreadPool(uint32_t _workers)
+    {
+        job = nullptr;
+        jobCount = 0;
+        jobNext = 0;
+        jobPending = 0;
+        jobActive = 0;
+        generation = 0;
+        quit = false;
+
+        if (0 == _workers)
+        {
+            uint32_t hw = std::thread::hardware_concurrency();
+            _workers = hw > 1 ? hw - 1 : 0;
+        }
+
+        workers.reserve(_workers);
+        for (uint32_t i = 0; i < _workers; i++)
+        {
+            workers.emplace_back(&ThreadPool::workerMain, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wakeCv.notify_all();
+
+        for (auto it = workers.begin(); it != workers.end(); ++it)
+        {
+            it->join();
+        }
+    }
+
+    void ThreadPool::parallelFor(uint32_t _count, const std::function<void(uint32_t)>& _fn)
+    {
+        if (0 == _count) return;
+
+        if (1 == _count || workers.empty())
+        {
+            for (uint32_t i = 0; i < _count; i++) _fn(i);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &_fn;
+            jobCount = _count;
+            jobNext = 0;
+            jobPending = _count;
+            generation++;
+        }
+        wakeCv.notify_all();
+
+        // the calling thread helps instead of just sitting there waiting
+        uint32_t done = runTasks(_fn, _count);
+
+        // also wait for every worker to let go of the job, so none of them can
+        // pick up indices of the next one with this (soon dangling) function.
+        std::unique_lock<std::mutex> lock(mutex);
+        jobPending -= done;
+        doneCv.wait(lock, [this] { return 0 == jobPending && 0 == jobActive; });
+        job = nullptr;
+    }
+
+    uint32_t ThreadPool::getThreadCount()
+    {
+        return workers.size() + 1;
+    }
+
+    void ThreadPool::workerMain()
+    {
+        uint64_t seen = 0;
+
+        while (true)
+        {
+            const std::function<void(uint32_t)>* fn;
+            uint32_t count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeCv.wait(lock, [this, seen] { return quit || (nullptr != job && generation != seen); });
+
+                if (quit) return;
+
+                seen = generation;
+                fn = job;
+                count = jobCount;
+                jobActive++;
+            }
+
+            uint32_t done = runTasks(*fn, count);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobPending -= done;
+                jobActive--;
+            }
+            doneCv.notify_all();
+        }
+    }
+
+    uint32_t ThreadPool::runTasks(const std::function<void(uint32_t)>& _fn, uint32_t _count)
+    {
+        uint32_t done = 0;
+        uint32_t i;
+
+        while ((i = jobNext.fetch_add(1)) < _count)
+        {
+            _fn(i);
+            done++;
+        }
+
+        return done;
+    }
+}
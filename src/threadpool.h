@@ -0,0 +1,46 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace finter
+{
+    class ThreadPool
+    {
+    public:
+                                        ThreadPool(uint32_t _workers = 0);
+                                        ~ThreadPool();
+
+        // runs _fn(0) ... _fn(_count - 1) spread across the workers and the calling thread.
+        // blocks until every task is done.
+        void                            parallelFor(uint32_t _count, const std::function<void(uint32_t)>& _fn);
+
+        // number of threads taking part in a parallelFor (workers + caller).
+        uint32_t                        getThreadCount();
+
+    private:
+        std::vector<std::thread>        workers;
+        std::mutex                      mutex;
+        std::condition_variable         wakeCv;
+        std::condition_variable         doneCv;
+
+        const std::function<void(uint32_t)>* job;
+        uint32_t                        jobCount;
+        std::atomic<uint32_t>           jobNext;
+        uint32_t                        jobPending;
+        uint32_t                        jobActive;
+        uint64_t                        generation;
+        bool                            quit;
+
+        void                            workerMain();
+        uint32_t                        runTasks(const std::function<void(uint32_t)>& _fn, uint32_t _count);
+    };
+}
+
+#endif // THREADPOOL_H_
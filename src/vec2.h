@@ -0,0 +1,25 @@
+#ifndef VEC2_H_
+#define VEC2_H_
+
+#ifndef FINTER_HEADLESS
+#   include "imgui.h"
+#endif
+
+namespace finter
+{
+#ifdef FINTER_HEADLESS
+    // stand-in for ImVec2, so the interpolation core builds without imgui.
+    struct Vec2
+    {
+        float                           x;
+        float                           y;
+
+        Vec2() : x(0.0f), y(0.0f) {}
+        Vec2(float _x, float _y) : x(_x), y(_y) {}
+    };
+#else
+    typedef ImVec2 Vec2;
+#endif
+}
+
+#endif // VEC2_H_